@@ -0,0 +1,92 @@
+#include "RLBotActionCache.h"
+#include "RLBotClient.h"
+#include <cmath>
+
+using namespace RLGC;
+
+ActionCache::Phase ActionCache::GetPhase(const RLBotPacket& packet) {
+    // isRoundActive is also false during goal replays and on the pre/post-match screens,
+    //  only the kickoff pause resets every car to a spawn spot
+    if (!packet.isKickoffPause || packet.isRoundActive)
+        return Phase::NONE;
+
+    const PhysState& ball = packet.ball;
+    bool ballAtRest = std::abs(ball.pos.x) < 1 && std::abs(ball.pos.y) < 1 && ball.vel.Length() < 1;
+    if (!ballAtRest)
+        return Phase::NONE;
+
+    return Phase::COUNTDOWN;
+}
+
+ActionCache::ActionCache(ObsBuilder* obsBuilder, float quantizeStep, size_t maxEntries)
+    : obsBuilder(obsBuilder), quantizeStep(quantizeStep), maxEntries(maxEntries) {
+}
+
+void ActionCache::SetCheckpoint(uint64_t newCheckpointHash) {
+    if (newCheckpointHash != checkpointHash) {
+        Clear();
+        checkpointHash = newCheckpointHash;
+    }
+}
+
+bool ActionCache::Lookup(const Player& player, const GameState& state, Action& outAction) {
+    FList obs = obsBuilder->BuildObs(player, state);
+
+    lastKey.resize(obs.size());
+    for (size_t i = 0; i < obs.size(); i++)
+        lastKey[i] = (int32_t)std::lround(obs[i] / quantizeStep);
+
+    // FNV-1a
+    lastKeyHash = 0xcbf29ce484222325ull;
+    for (int32_t val : lastKey) {
+        lastKeyHash ^= (uint32_t)val;
+        lastKeyHash *= 0x100000001b3ull;
+    }
+    hasLastKey = true;
+
+    lookups++;
+    totalLookups++;
+
+    auto itr = entries.find(lastKeyHash);
+    if (itr == entries.end() || itr->second.key != lastKey)
+        return false;
+
+    hits++;
+    totalHits++;
+    itr->second.lastUsed = ++useCounter;
+    outAction = itr->second.action;
+    return true;
+}
+
+void ActionCache::Store(const Action& action) {
+    if (!hasLastKey)
+        return;
+    hasLastKey = false;
+
+    // Kickoff states come from a handful of spawn spots, so a full cache only happens if something non-repeating got in
+    // Scanning for the stalest entry is slow, but that should almost never happen
+    if (entries.size() >= maxEntries && !entries.count(lastKeyHash)) {
+        auto stalest = entries.begin();
+        for (auto itr = entries.begin(); itr != entries.end(); itr++)
+            if (itr->second.lastUsed < stalest->second.lastUsed)
+                stalest = itr;
+        entries.erase(stalest);
+    }
+
+    entries[lastKeyHash] = { std::move(lastKey), action, ++useCounter };
+}
+
+void ActionCache::Clear() {
+    entries.clear();
+    hasLastKey = false;
+}
+
+void ActionCache::ReportStats(const char* label) {
+    if (lookups == 0)
+        return;
+
+    RG_LOG("ActionCache: " << hits << "/" << lookups << " hits " << label
+        << " (" << (int)(100.0 * hits / lookups) << "%), "
+        << totalHits << "/" << totalLookups << " total, " << entries.size() << " entries");
+    hits = lookups = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <RLGymCPP/ObsBuilders/ObsBuilder.h>
+#include <RLGymCPP/Framework.h>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+struct RLBotPacket;
+
+// Memoizes deterministic policy actions for the exactly repeating states at the start of a round
+// States are keyed on the quantized observation, so both teams' kickoff spots share entries
+// Only used inside the phases below, everywhere else inference always runs
+class ActionCache {
+public:
+    enum class Phase {
+        NONE,
+        COUNTDOWN // Kickoff countdown (also after a goal), cars frozen at their spawn spots
+    };
+
+    // The countdown also needs the ball resting at center, so replays, celebrations and menus are never cached
+    // Once the countdown ends the cars move and the state depends on the opponent, so it rarely repeats exactly
+
+    static Phase GetPhase(const RLBotPacket& packet);
+
+    RLGC::ObsBuilder* obsBuilder;
+    float quantizeStep;
+    size_t maxEntries;
+
+    // Once full, the least recently used entry makes room for each new one
+    ActionCache(RLGC::ObsBuilder* obsBuilder, float quantizeStep, size_t maxEntries = 4096);
+
+    // Drops every entry if the checkpoint changed
+    void SetCheckpoint(uint64_t checkpointHash);
+
+    // Returns true and sets outAction on a hit
+    // On a miss, the key is kept so the inferred action can be passed to Store()
+    // The observation is built here, so a miss builds it again inside inference
+    bool Lookup(const RLGC::Player& player, const RLGC::GameState& state, RLGC::Action& outAction);
+    void Store(const RLGC::Action& action);
+
+    void Clear();
+
+    // Logs and resets the hit rate since the last report
+    void ReportStats(const char* label);
+
+private:
+    struct Entry {
+        std::vector<int32_t> key;
+        RLGC::Action action;
+        uint64_t lastUsed;
+    };
+    std::unordered_map<uint64_t, Entry> entries;
+
+    uint64_t checkpointHash = 0;
+    std::vector<int32_t> lastKey;
+    uint64_t lastKeyHash = 0;
+    bool hasLastKey = false;
+
+    uint64_t useCounter = 0;
+
+    uint64_t hits = 0, lookups = 0;
+    uint64_t totalHits = 0, totalLookups = 0;
+};
@@ -0,0 +1,401 @@
+#include "RLBotAffinity.h"
+#include "RLBotPlatform.h"
+#include <RLGymCPP/Framework.h>
+#include <ATen/Config.h>
+#include <ATen/Parallel.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sched.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if AT_PARALLEL_OPENMP
+#include <omp.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Host-wide lease table, opened and exclusively locked for the lifetime of the object
+class LeaseFile {
+public:
+    LeaseFile() {
+        fs::path path = fs::temp_directory_path() / "gigalearn_rlbot_cores.lock";
+#ifdef _WIN32
+        handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (handle == INVALID_HANDLE_VALUE)
+            return;
+        OVERLAPPED overlapped = {};
+        locked = LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (fd < 0)
+            return;
+        locked = flock(fd, LOCK_EX) == 0;
+#endif
+    }
+
+    ~LeaseFile() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) {
+            if (locked) {
+                OVERLAPPED overlapped = {};
+                UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+            }
+            CloseHandle(handle);
+        }
+#else
+        if (fd >= 0) {
+            if (locked)
+                flock(fd, LOCK_UN);
+            close(fd);
+        }
+#endif
+    }
+
+    bool IsLocked() const { return locked; }
+
+    // Slot -> PID
+    std::map<int, uint32_t> Read() {
+        std::string text;
+        char buf[512];
+#ifdef _WIN32
+        SetFilePointer(handle, 0, NULL, FILE_BEGIN);
+        DWORD bytesRead;
+        while (ReadFile(handle, buf, sizeof(buf), &bytesRead, NULL) && bytesRead > 0)
+            text.append(buf, bytesRead);
+#else
+        lseek(fd, 0, SEEK_SET);
+        ssize_t bytesRead;
+        while ((bytesRead = read(fd, buf, sizeof(buf))) > 0)
+            text.append(buf, bytesRead);
+#endif
+
+        std::map<int, uint32_t> leases;
+        std::istringstream stream(text);
+        int slot;
+        uint32_t pid;
+        while (stream >> slot >> pid)
+            leases[slot] = pid;
+        return leases;
+    }
+
+    void Write(const std::map<int, uint32_t>& leases) {
+        std::ostringstream stream;
+        for (auto& pair : leases)
+            stream << pair.first << " " << pair.second << "\n";
+        std::string text = stream.str();
+#ifdef _WIN32
+        SetFilePointer(handle, 0, NULL, FILE_BEGIN);
+        SetEndOfFile(handle);
+        DWORD bytesWritten;
+        WriteFile(handle, text.data(), (DWORD)text.size(), &bytesWritten, NULL);
+#else
+        if (ftruncate(fd, 0) == 0) {
+            lseek(fd, 0, SEEK_SET);
+            ssize_t unused = write(fd, text.data(), text.size());
+            (void)unused;
+        }
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+    bool locked = false;
+};
+
+// One physical core: its logical CPUs (SMT siblings), lowest first
+using PhysicalCore = std::vector<int>;
+
+#ifdef __linux__
+// Parses the kernel's CPU list format, e.g. "0-3,8,10-11"
+static std::vector<int> ReadCpuList(const std::string& path) {
+    std::vector<int> result;
+    std::ifstream in(path);
+    std::string list;
+    if (!std::getline(in, list))
+        return result;
+
+    std::istringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++)
+                result.push_back(cpu);
+        } catch (...) {
+            return {};
+        }
+    }
+    return result;
+}
+#endif
+
+// Physical cores this process may run on, in order of their lowest logical CPU
+static std::vector<PhysicalCore> GetAvailableCores() {
+    std::map<int, PhysicalCore> coresByFirstCpu;
+
+#ifdef _WIN32
+    // Only processor group 0, same as the affinity masks used below
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        processMask = ~(DWORD_PTR)0;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformation(NULL, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (!infos.empty() && GetLogicalProcessorInformation(infos.data(), &length)) {
+        for (auto& info : infos) {
+            if (info.Relationship != RelationProcessorCore)
+                continue;
+
+            PhysicalCore core;
+            for (int cpu = 0; cpu < (int)(sizeof(DWORD_PTR) * 8); cpu++)
+                if ((info.ProcessorMask & processMask) & ((DWORD_PTR)1 << cpu))
+                    core.push_back(cpu);
+            if (!core.empty())
+                coresByFirstCpu[core.front()] = core;
+        }
+    }
+#else
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool hasMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    int cpuAmount = hasMask ? CPU_SETSIZE : (int)std::thread::hardware_concurrency();
+
+    for (int cpu = 0; cpu < cpuAmount; cpu++) {
+        if (hasMask && !CPU_ISSET(cpu, &allowed))
+            continue;
+
+        PhysicalCore core;
+#ifdef __linux__
+        for (int sibling : ReadCpuList("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"))
+            if (!hasMask || CPU_ISSET(sibling, &allowed))
+                core.push_back(sibling);
+#endif
+        if (core.empty())
+            core.push_back(cpu);
+        coresByFirstCpu[core.front()] = core;
+    }
+#endif
+
+    std::vector<PhysicalCore> result;
+    for (auto& pair : coresByFirstCpu)
+        result.push_back(pair.second);
+    return result;
+}
+
+std::unique_ptr<CoreLease> CoreLease::Acquire(int coresPerProcess) {
+    std::vector<PhysicalCore> available = GetAvailableCores();
+    if (coresPerProcess < 1 || coresPerProcess > (int)available.size()) {
+        RG_LOG("CoreLease: Can't fit " << coresPerProcess << " cores per process in the "
+            << available.size() << " physical core(s) available to this process");
+        return nullptr;
+    }
+
+    LeaseFile file;
+    if (!file.IsLocked()) {
+        RG_LOG("CoreLease: Failed to lock the lease file, threads will not be pinned");
+        return nullptr;
+    }
+
+    auto leases = file.Read();
+    for (auto itr = leases.begin(); itr != leases.end();) {
+        if (!RLBotPlatform::IsProcessAlive(itr->second)) {
+            itr = leases.erase(itr);
+        } else {
+            itr++;
+        }
+    }
+
+    std::vector<const PhysicalCore*> freeCores;
+    for (auto& core : available)
+        if (!leases.count(core.front()))
+            freeCores.push_back(&core);
+
+    if ((int)freeCores.size() < coresPerProcess) {
+        file.Write(leases);
+        RG_LOG("CoreLease: Only " << freeCores.size() << " of this process's " << available.size()
+            << " physical core(s) are free, threads will not be pinned");
+        return nullptr;
+    }
+
+    std::unique_ptr<CoreLease> lease(new CoreLease());
+    uint32_t pid = RLBotPlatform::GetPID();
+    for (int i = 0; i < coresPerProcess; i++) {
+        const PhysicalCore& core = *freeCores[i];
+        leases[core.front()] = pid;
+        lease->cores.push_back(core.front());
+        lease->cpus.insert(lease->cpus.end(), core.begin(), core.end());
+    }
+    file.Write(leases);
+
+    std::string coreList;
+    for (int core : lease->cores)
+        coreList += (coreList.empty() ? "" : ",") + std::to_string(core);
+    RG_LOG("CoreLease: Claimed physical cores {" << coreList << "} (" << lease->cpus.size() << " logical CPUs, "
+        << leases.size() << "/" << available.size() << " cores leased on this host)");
+    return lease;
+}
+
+CoreLease::~CoreLease() {
+    LeaseFile file;
+    if (!file.IsLocked())
+        return;
+
+    auto leases = file.Read();
+    uint32_t pid = RLBotPlatform::GetPID();
+    for (int core : cores) {
+        auto itr = leases.find(core);
+        if (itr != leases.end() && itr->second == pid)
+            leases.erase(itr);
+    }
+    file.Write(leases);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool SetProcessCores(const std::vector<int>& cores) {
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int core : cores)
+        if (core < (int)(sizeof(DWORD_PTR) * 8))
+            mask |= (DWORD_PTR)1 << core;
+    return mask && SetProcessAffinityMask(GetCurrentProcess(), mask);
+#else
+    // Only sets the calling thread, which is why this has to run before other threads are started
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : cores)
+        CPU_SET(core, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+}
+
+static bool PinCurrentThread(int core) {
+#ifdef _WIN32
+    if (core >= (int)(sizeof(DWORD_PTR) * 8))
+        return false;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+static bool SetCurrentThreadCores(const std::vector<int>& cores) {
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int core : cores)
+        if (core < (int)(sizeof(DWORD_PTR) * 8))
+            mask |= (DWORD_PTR)1 << core;
+    return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : cores)
+        CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+void RLBotAffinity::ApplyProcessSettings(const RLBotThreadParams& threadParams, const CoreLease* lease) {
+    if (lease) {
+        if (!SetProcessCores(lease->GetCpus()))
+            RG_LOG("RLBotAffinity: Failed to restrict the process to its leased cores");
+    }
+
+    int inferenceThreads = threadParams.inferenceThreads;
+    if (inferenceThreads <= 0 && lease)
+        inferenceThreads = (int)lease->GetCores().size();
+
+    if (inferenceThreads > 0) {
+        // Environment variables are too late here, OpenMP has already read them when the process was loaded
+        at::set_num_threads(inferenceThreads);
+
+        // Inference runs one op at a time, the inter-op pool would otherwise get a thread per host CPU
+        try {
+            at::set_num_interop_threads(1);
+        } catch (std::exception& e) {
+            RG_LOG("RLBotAffinity: Failed to size the inter-op thread pool: " << e.what());
+        }
+    }
+
+    if (threadParams.elevatedPriority) {
+#ifdef _WIN32
+        bool raised = SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+#else
+        bool raised = setpriority(PRIO_PROCESS, 0, -10) == 0;
+#endif
+        if (!raised)
+            RG_LOG("RLBotAffinity: Failed to raise process priority (missing permissions?)");
+    }
+}
+
+void RLBotAffinity::ApplyTickThreadSettings(const RLBotThreadParams& threadParams, const std::vector<int>& cores) {
+    if (threadParams.pinTickThread && !cores.empty()) {
+        if (!PinCurrentThread(cores.front()))
+            RG_LOG("RLBotAffinity: Failed to pin the tick thread to core " << cores.front());
+    }
+
+    if (threadParams.pinInferenceThreads && cores.size() > 1) {
+        // Pool threads are persistent and this thread drives them, so pinning each one once from inside
+        //  a parallel region sticks. Thread 0 is this thread itself (see pinTickThread)
+        int poolSize = at::get_num_threads();
+        std::atomic<int> pinFailures = 0;
+        at::parallel_for(0, poolSize, 1, [&](int64_t, int64_t) {
+            int threadNum = at::get_thread_num();
+            if (threadNum > 0 && !PinCurrentThread(cores[threadNum % cores.size()]))
+                pinFailures++;
+        });
+
+        if (pinFailures > 0)
+            RG_LOG("RLBotAffinity: Failed to pin " << pinFailures << " inference thread(s)");
+    }
+
+#ifdef _WIN32
+    if (threadParams.elevatedPriority)
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#endif
+}
+
+void RLBotAffinity::ApplyBackgroundThreadSettings(const std::vector<int>& cores) {
+    // at::set_num_threads() is process-wide, but OpenMP keeps the thread count per calling thread,
+    //  so this only stops this thread's ops from fanning out over the pool the tick thread drives
+#if AT_PARALLEL_OPENMP
+    omp_set_num_threads(1);
+#else
+    RG_LOG("RLBotAffinity: Inference runtime doesn't use OpenMP, background inference will use the shared thread pool");
+#endif
+
+    // The tick thread is pinned to the first leased core
+    if (cores.size() > 1) {
+        if (!SetCurrentThreadCores(std::vector<int>(cores.begin() + 1, cores.end())))
+            RG_LOG("RLBotAffinity: Failed to keep a background thread off the tick thread's core");
+    } else if (cores.size() == 1) {
+        RG_LOG("RLBotAffinity: Only one core is leased, background inference shares it with the tick thread");
+    }
+}
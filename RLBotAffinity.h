@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+// Thread placement for packing many rlbot processes onto one host
+struct RLBotThreadParams {
+    // Claim a disjoint set of this many physical cores from the host-level coordinator (0 = don't, threads float freely)
+    int coresPerProcess = 0;
+
+    // Pin the tick thread (the one running state tracking and inference) to the first core of the set
+    bool pinTickThread = false;
+
+    // Intra-op inference threads (libtorch's pool), including the tick thread that drives them
+    // -1 = one per leased core, or the runtime's default without a lease
+    int inferenceThreads = -1;
+
+    // Pin each inference pool thread to its own leased core
+    bool pinInferenceThreads = false;
+
+    // Ask the OS for above-normal scheduling priority (may need elevated permissions on Linux)
+    bool elevatedPriority = false;
+};
+
+// Host-level coordinator that hands each rlbot process a disjoint set of physical cores
+// Only cores this process may run on (its inherited affinity mask, which includes cgroup cpusets on Linux) are considered,
+//  and SMT siblings are always leased together, so two processes never share a physical core
+// Leases are "cpu pid" lines in a lock file in the temp folder, edited under an exclusive file lock,
+//  with each physical core keyed by its lowest logical CPU. Cores held by dead processes are reclaimed
+class CoreLease {
+public:
+    // Returns nullptr if not enough free physical cores are left
+    static std::unique_ptr<CoreLease> Acquire(int coresPerProcess);
+
+    ~CoreLease();
+    CoreLease(const CoreLease&) = delete;
+    CoreLease& operator=(const CoreLease&) = delete;
+
+    // One logical CPU per leased physical core (its lowest), for pinning threads
+    const std::vector<int>& GetCores() const { return cores; }
+
+    // Every logical CPU of the leased physical cores, including SMT siblings
+    const std::vector<int>& GetCpus() const { return cpus; }
+
+private:
+    CoreLease() = default;
+
+    std::vector<int> cores, cpus;
+};
+
+namespace RLBotAffinity {
+    // Call at startup, before any other threads or the inference runtime exist, so everything created later inherits it
+    // lease may be nullptr
+    void ApplyProcessSettings(const RLBotThreadParams& threadParams, const CoreLease* lease);
+
+    // Call from the tick thread itself, before its first inference, so the pool it drives is placed along with it
+    void ApplyTickThreadSettings(const RLBotThreadParams& threadParams, const std::vector<int>& cores);
+
+    // Call from a background inference thread (like the shadow evaluator's) before its first inference
+    // Its inference then runs on that thread alone, off the tick thread's core if more than one is leased
+    void ApplyBackgroundThreadSettings(const std::vector<int>& cores);
+}
@@ -0,0 +1,269 @@
+#include "RLBotCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+using namespace RLGC;
+
+static const char* COLUMN_NAMES[ColumnCapture::COLUMN_AMOUNT] = { "obs", "action", "tick", "team" };
+
+ColumnCapture::ColumnCapture(const std::filesystem::path& dir, const std::string& filePrefix,
+    ObsBuilder* obsBuilder, ActionParser* actionParser, int obsSize,
+    uint64_t rowsPerSegment, int flushIntervalMs)
+    : dir(dir), filePrefix(filePrefix), obsBuilder(obsBuilder), actionParser(actionParser), obsSize(obsSize),
+    rowsPerSegment(RS_MAX(rowsPerSegment, 1)), flushIntervalMs(flushIntervalMs) {
+
+    rowBytes[COL_OBS] = sizeof(float) * obsSize;
+    rowBytes[COL_ACTION] = sizeof(int32_t);
+    rowBytes[COL_TICK] = sizeof(int32_t);
+    rowBytes[COL_TEAM] = sizeof(int32_t);
+
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+
+    // The first segment is made here, every later one by the flusher ahead of time
+    current = CreateSegment();
+    if (!current) {
+        RG_LOG("ColumnCapture: Failed to create capture files in " << dir << ", capture disabled");
+        return;
+    }
+
+    RG_LOG("ColumnCapture: Capturing to " << dir << " (" << filePrefix << "_*), "
+        << this->rowsPerSegment << " rows per segment");
+    flusherThread = std::thread(&ColumnCapture::FlusherLoop, this);
+    writerThread = std::thread(&ColumnCapture::WriterLoop, this);
+}
+
+ColumnCapture::~ColumnCapture() {
+    // The writer finishes the queued steps first
+    queue.Interrupt();
+    if (writerThread.joinable())
+        writerThread.join();
+
+    if (flusherThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopFlusher = true;
+        }
+        flusherCV.notify_all();
+        flusherThread.join();
+    }
+
+    // The flusher closed everything that was retired before it stopped
+    for (Segment* segment : retired)
+        CloseSegment(segment);
+    if (current)
+        CloseSegment(current);
+    if (spare)
+        CloseSegment(spare);
+
+    uint64_t drops = droppedRows + overflowSteps;
+    if (writtenRows > 0 || drops > 0)
+        RG_LOG("ColumnCapture: Captured " << writtenRows << " rows to " << dir << ", " << drops << " dropped");
+}
+
+void ColumnCapture::Submit(int32_t tick, int playerIndex, const GameState& state, const Action& action) {
+    if (!queue.Push(PolicyStep::Copy(tick, playerIndex, state, action)))
+        overflowSteps++;
+
+    // RLBot kills the process instead of letting it shut down, so drops are reported as they happen
+    if (tick - lastDropReportTick >= DROP_REPORT_INTERVAL || tick < lastDropReportTick) {
+        uint64_t drops = droppedRows.load(std::memory_order_relaxed) + overflowSteps;
+        if (drops > reportedDrops) {
+            RG_LOG("ColumnCapture: Dropped " << (drops - reportedDrops) << " row(s) (" << drops << " total), "
+                << "capture can't keep up");
+            reportedDrops = drops;
+        }
+        lastDropReportTick = tick;
+    }
+}
+
+void ColumnCapture::WriterLoop() {
+    if (!RLBotPlatform::SetCurrentThreadLowPriority())
+        RG_LOG("ColumnCapture: Failed to lower writer thread priority");
+
+    std::unique_ptr<PolicyStep> step;
+    while (queue.WaitPop(step))
+        WriteStep(*step);
+}
+
+void ColumnCapture::WriteStep(const PolicyStep& step) {
+    // The state is a copy of exactly what the policy saw (including orange's inverted pads)
+    const Player& player = step.state.players[step.playerIndex];
+    FList obs = obsBuilder->BuildObs(player, step.state);
+    Append(step.frameNum, (int32_t)player.team, obs, GetActionIndex(step.action, player, step.state));
+}
+
+void ColumnCapture::Append(int32_t tick, int32_t team, const FList& obs, int32_t action) {
+    Segment* segment = current;
+    if (!segment || segment->rowCount == rowsPerSegment) {
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            droppedRows++;
+            return;
+        }
+
+        if (segment)
+            retired.push_back(segment);
+        current = segment = spare;
+        spare = nullptr;
+        lock.unlock();
+        flusherCV.notify_one();
+
+        if (!segment) {
+            droppedRows++;
+            return;
+        }
+    }
+
+    uint64_t row = segment->rowCount;
+
+    float* obsDst = (float*)segment->data[COL_OBS] + row * obsSize;
+    size_t copyAmount = RS_MIN(obs.size(), (size_t)obsSize);
+    memcpy(obsDst, obs.data(), copyAmount * sizeof(float));
+    if (copyAmount < obsSize)
+        memset(obsDst + copyAmount, 0, (obsSize - copyAmount) * sizeof(float));
+
+    ((int32_t*)segment->data[COL_ACTION])[row] = action;
+    ((int32_t*)segment->data[COL_TICK])[row] = tick;
+    ((int32_t*)segment->data[COL_TEAM])[row] = team;
+
+    // Only count the row once all of it is in, so readers never see a partial one
+    segment->rowCount = row + 1;
+    for (int i = 0; i < COLUMN_AMOUNT; i++)
+        std::atomic_ref<uint64_t>(segment->headers[i]->rowCount).store(row + 1, std::memory_order_release);
+    segment->committedRows.store(row + 1, std::memory_order_release);
+    writtenRows++;
+}
+
+int ColumnCapture::GetActionIndex(const Action& action, const Player& player, const GameState& state) {
+    if (actionTable.empty()) {
+        int actionAmount = actionParser->GetActionAmount();
+        actionTable.resize(actionAmount);
+        for (int i = 0; i < actionAmount; i++)
+            actionTable[i] = actionParser->ParseAction(i, player, state);
+    }
+
+    for (int i = 0; i < actionTable.size(); i++) {
+        bool match = true;
+        for (int j = 0; j < Action::ELEM_AMOUNT && match; j++)
+            match = actionTable[i][j] == action[j];
+        if (match)
+            return i;
+    }
+    return -1;
+}
+
+ColumnCapture::Segment* ColumnCapture::CreateSegment() {
+    auto segment = new Segment();
+    segment->number = nextSegmentNumber++;
+
+    char numberStr[16];
+    snprintf(numberStr, sizeof(numberStr), "%05d", segment->number);
+
+    for (int i = 0; i < COLUMN_AMOUNT; i++) {
+        std::filesystem::path path = dir / (filePrefix + "_" + numberStr + "." + COLUMN_NAMES[i]);
+        size_t size = sizeof(CaptureColumnHeader) + rowBytes[i] * rowsPerSegment;
+
+        if (!RLBotPlatform::CreateMappedFile(path, size, segment->files[i])) {
+            RG_LOG("ColumnCapture: Failed to create " << path);
+            for (int j = 0; j < i; j++)
+                RLBotPlatform::CloseMappedFile(segment->files[j], 0);
+            delete segment;
+            return nullptr;
+        }
+
+        auto header = (CaptureColumnHeader*)segment->files[i].data;
+        memset(header, 0, sizeof(CaptureColumnHeader));
+        memcpy(header->magic, CaptureColumnHeader::MAGIC, sizeof(header->magic));
+        strncpy(header->name, COLUMN_NAMES[i], sizeof(header->name) - 1);
+        header->elemType = (i == COL_OBS) ? CaptureColumnHeader::FLOAT32 : CaptureColumnHeader::INT32;
+        header->elemsPerRow = (i == COL_OBS) ? obsSize : 1;
+        header->rowCapacity = rowsPerSegment;
+        header->rowCount = 0;
+
+        segment->headers[i] = header;
+        segment->data[i] = (uint8_t*)segment->files[i].data + sizeof(CaptureColumnHeader);
+
+        // Fault every page in now, so the writer thread's first write to each one doesn't
+        for (size_t offset = 0; offset < size; offset += 4096)
+            ((volatile uint8_t*)segment->files[i].data)[offset] = ((uint8_t*)segment->files[i].data)[offset];
+    }
+
+    return segment;
+}
+
+void ColumnCapture::FlushSegment(Segment* segment) {
+    uint64_t rows = segment->committedRows.load(std::memory_order_acquire);
+    if (rows == segment->flushedRows)
+        return;
+
+    for (int i = 0; i < COLUMN_AMOUNT; i++) {
+        size_t start = sizeof(CaptureColumnHeader) + segment->flushedRows * rowBytes[i];
+        size_t length = (rows - segment->flushedRows) * rowBytes[i];
+        RLBotPlatform::FlushMappedFile(segment->files[i], start, length);
+        RLBotPlatform::FlushMappedFile(segment->files[i], 0, sizeof(CaptureColumnHeader));
+    }
+    segment->flushedRows = rows;
+}
+
+void ColumnCapture::CloseSegment(Segment* segment) {
+    uint64_t rows = segment->committedRows.load(std::memory_order_acquire);
+    FlushSegment(segment);
+
+    for (int i = 0; i < COLUMN_AMOUNT; i++) {
+        RLBotPlatform::CloseMappedFile(segment->files[i], sizeof(CaptureColumnHeader) + rows * rowBytes[i]);
+
+        // Nothing was captured into it (the spare at shutdown), don't leave empty files around
+        if (rows == 0) {
+            char numberStr[16];
+            snprintf(numberStr, sizeof(numberStr), "%05d", segment->number);
+            std::error_code error;
+            std::filesystem::remove(dir / (filePrefix + "_" + numberStr + "." + COLUMN_NAMES[i]), error);
+        }
+    }
+
+    delete segment;
+}
+
+void ColumnCapture::FlusherLoop() {
+    if (!RLBotPlatform::SetCurrentThreadLowPriority())
+        RG_LOG("ColumnCapture: Failed to lower flusher thread priority");
+
+    bool loggedSpareFailure = false;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        flusherCV.wait_for(lock, std::chrono::milliseconds(flushIntervalMs),
+            [&] { return stopFlusher || !retired.empty(); });
+
+        bool stopping = stopFlusher;
+        Segment* segment = current;
+        std::vector<Segment*> toClose = std::move(retired);
+        retired.clear();
+        bool needSpare = !spare && !stopping;
+        lock.unlock();
+
+        // Only the flusher ever deletes segments, so the current one stays valid even if the writer thread retires it meanwhile
+        if (segment)
+            FlushSegment(segment);
+        for (Segment* closing : toClose)
+            CloseSegment(closing);
+
+        if (stopping)
+            break;
+
+        if (needSpare) {
+            Segment* newSpare = CreateSegment();
+            if (newSpare) {
+                lock.lock();
+                spare = newSpare;
+                lock.unlock();
+                loggedSpareFailure = false;
+            } else if (!loggedSpareFailure) {
+                RG_LOG("ColumnCapture: Failed to create the next segment, rows will be dropped once the current one is full");
+                loggedSpareFailure = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "RLBotMailbox.h"
+#include "RLBotPlatform.h"
+#include "RLBotPolicyStep.h"
+#include <RLGymCPP/ActionParsers/ActionParser.h>
+#include <RLGymCPP/ObsBuilders/ObsBuilder.h>
+#include <RLGymCPP/Framework.h>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// Start of every capture column file, the column's rows follow right after it
+// Offline tools can read a column file in place without parsing anything, e.g. in numpy:
+//  np.memmap(path, dtype, mode="r", offset=64, shape=(rowCount, elemsPerRow))
+struct CaptureColumnHeader {
+    static constexpr char MAGIC[8] = "GLCOL01";
+
+    enum ElemType : uint32_t {
+        FLOAT32 = 0,
+        INT32 = 1
+    };
+
+    char magic[8];
+    char name[16];
+    uint32_t elemType;
+    uint32_t elemsPerRow;
+    uint64_t rowCapacity;
+    // Amount of complete rows, only ever grows, updated after each row is written
+    uint64_t rowCount;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(CaptureColumnHeader) == 64, "Capture column header layout changed");
+
+// Captures every policy step (observation, chosen action index, tick, team) into memory-mapped column files
+// Each segment is one preallocated file per column, "<prefix>_<segment number>.<column>"
+// The tick thread only copies the state the policy acted on into a bounded queue. A writer thread builds the obs from it
+//  (with its own obs builder), finds the action index and copies the row into the mapped memory. A flusher thread writes dirty rows back to disk,
+//  prepares the next segment before the current one fills up, and closes full segments (cut down to their row count)
+class ColumnCapture {
+public:
+    // Steps the writer may fall behind by before new ones are dropped
+    static constexpr size_t QUEUE_SIZE = 256;
+
+    // Drops are logged at most this often, in ticks
+    static constexpr int DROP_REPORT_INTERVAL = 120 * 30;
+
+    enum Column {
+        COL_OBS, // float32[obsSize]
+        COL_ACTION, // int32, index into the action parser's actions, -1 if the action isn't one of them
+        COL_TICK, // int32, packet frame number
+        COL_TEAM, // int32
+
+        COLUMN_AMOUNT
+    };
+
+    std::filesystem::path dir;
+    std::string filePrefix;
+    // Only used on the writer thread, so these can't be the instances the policy uses
+    RLGC::ObsBuilder* obsBuilder;
+    RLGC::ActionParser* actionParser;
+    int obsSize;
+    uint64_t rowsPerSegment;
+    int flushIntervalMs;
+
+    ColumnCapture(const std::filesystem::path& dir, const std::string& filePrefix,
+        RLGC::ObsBuilder* obsBuilder, RLGC::ActionParser* actionParser, int obsSize,
+        uint64_t rowsPerSegment, int flushIntervalMs);
+    ~ColumnCapture();
+
+    bool IsOpen() const { return current != nullptr; }
+
+    // Called on the tick thread after the policy acted, only copies the state and never blocks or touches the disk
+    // The step is dropped if the writer is QUEUE_SIZE steps behind
+    void Submit(int32_t tick, int playerIndex, const RLGC::GameState& state, const RLGC::Action& action);
+
+private:
+    struct Segment {
+        int number;
+        RLBotPlatform::MappedFile files[COLUMN_AMOUNT];
+        CaptureColumnHeader* headers[COLUMN_AMOUNT];
+        uint8_t* data[COLUMN_AMOUNT];
+
+        uint64_t rowCount = 0; // Writer thread
+        std::atomic<uint64_t> committedRows = 0;
+        uint64_t flushedRows = 0; // Flusher thread
+    };
+
+    size_t rowBytes[COLUMN_AMOUNT];
+
+    SpscRing<std::unique_ptr<PolicyStep>> queue{ QUEUE_SIZE };
+
+    // Tick thread
+    uint64_t overflowSteps = 0, reportedDrops = 0;
+    int32_t lastDropReportTick = 0;
+
+    // Writer thread
+    std::thread writerThread;
+    Segment* current = nullptr;
+    uint64_t writtenRows = 0;
+    std::atomic<uint64_t> droppedRows = 0; // Also read by the tick thread, for drop reports
+    std::vector<RLGC::Action> actionTable;
+
+    // Guarded by mutex, the writer thread only ever try-locks it
+    std::mutex mutex;
+    std::condition_variable flusherCV;
+    Segment* spare = nullptr;
+    std::vector<Segment*> retired;
+    bool stopFlusher = false;
+
+    // Flusher thread (and the constructor, before it starts)
+    std::thread flusherThread;
+    int nextSegmentNumber = 0;
+
+    void WriterLoop();
+    void WriteStep(const PolicyStep& step);
+
+    // Obs longer than obsSize are cut off and shorter ones are zero-padded
+    // The row is dropped if the current segment is full and the next one isn't ready yet
+    void Append(int32_t tick, int32_t team, const FList& obs, int32_t action);
+
+    // Index of the action among the parser's actions, or -1
+    // The table is built on first use, assuming the parser's actions don't depend on the state (true for DefaultAction)
+    int GetActionIndex(const RLGC::Action& action, const RLGC::Player& player, const RLGC::GameState& state);
+
+    Segment* CreateSegment();
+    void FlushSegment(Segment* segment);
+    void CloseSegment(Segment* segment);
+    void FlusherLoop();
+};
@@ -2,6 +2,9 @@
 #include <rlbot/platform.h>
 #include <rlbot/botmanager.h>
 #include <cmath>
+#include <chrono>
+#include <ctime>
+#include <random>
 
 using namespace RLGC;
 using namespace GGL;
@@ -31,19 +34,131 @@ PhysState ToPhysState(const rlbot::flat::Physics* phys) {
     return obj;
 }
 
+RLBotPacket RLBotPacket::FromFlat(rlbot::GameTickPacket& packet) {
+    RLBotPacket result = {};
+
+    auto gameInfo = packet->gameInfo();
+    result.frameNum = gameInfo->frameNum();
+    result.secondsElapsed = gameInfo->secondsElapsed();
+    result.isKickoffPause = gameInfo->isKickoffPause();
+    result.isRoundActive = gameInfo->isRoundActive();
+
+    result.ball = ToPhysState(packet->ball()->physics());
+    auto latestTouch = packet->ball()->latestTouch();
+    if (latestTouch) {
+        result.hasLatestTouch = true;
+        result.latestTouch.playerIndex = latestTouch->playerIndex();
+        result.latestTouch.gameSeconds = latestTouch->gameSeconds();
+        result.latestTouch.location = ToVec(latestTouch->location());
+    }
+
+    auto boostPadStates = packet->boostPadStates();
+    if (boostPadStates) {
+        result.boostPads.resize(boostPadStates->size());
+        for (int i = 0; i < boostPadStates->size(); i++) {
+            result.boostPads[i].isActive = boostPadStates->Get(i)->isActive();
+            result.boostPads[i].timer = boostPadStates->Get(i)->timer();
+        }
+    }
+
+    auto players = packet->players();
+    result.cars.resize(players->size());
+    for (int i = 0; i < players->size(); i++) {
+        auto playerInfo = players->Get(i);
+        Car& car = result.cars[i];
+        car.phys = ToPhysState(playerInfo->physics());
+        car.spawnId = playerInfo->spawnId();
+        car.team = playerInfo->team();
+        car.boost = playerInfo->boost();
+        car.isDemolished = playerInfo->isDemolished();
+        car.hasWheelContact = playerInfo->hasWheelContact();
+        car.jumped = playerInfo->jumped();
+        car.doubleJumped = playerInfo->doubleJumped();
+        car.isSupersonic = playerInfo->isSupersonic();
+    }
+
+    for (int i = 0; i < 2; i++)
+        result.teamScores[i] = packet->teams()->Get(i)->score();
+
+    return result;
+}
+
+rlbot::Controller ToController(const Action& controls) {
+    rlbot::Controller output_controller = {};
+    output_controller.throttle = controls.throttle;
+    output_controller.steer = controls.steer;
+    output_controller.pitch = controls.pitch;
+    output_controller.yaw = controls.yaw;
+    output_controller.roll = controls.roll;
+    output_controller.jump = controls.jump != 0;
+    output_controller.boost = controls.boost != 0;
+    output_controller.handbrake = controls.handbrake != 0;
+    output_controller.useItem = false;
+    return output_controller;
+}
+
 RLBotBot::RLBotBot(int _index, int _team, std::string _name, const RLBotParams& params)
     : rlbot::Bot(_index, _team, _name), params(params) {
     RG_LOG("Created RLBot bot: index " << _index << ", name: " << name << "...");
+
+    if (params.useActionCache && params.deterministic)
+        actionCache = std::make_unique<ActionCache>(params.obsBuilder, params.actionCacheQuantizeStep);
+
+    if (params.shadowInferUnit) {
+        shadowEval = std::make_unique<ShadowEvaluator>(params.shadowInferUnit, params.deterministic, params.shadowCpuBudget,
+            params.cores, _index, "shadow_bot" + std::to_string(_index) + ".csv");
+    }
+
+    if (!params.recordPacketsDir.empty()) {
+        std::filesystem::create_directories(params.recordPacketsDir);
+        packetRecorder = std::make_unique<PacketRecorder>(
+            std::filesystem::path(params.recordPacketsDir) / ("packets_bot" + std::to_string(_index) + ".bin"), _index, _team);
+    }
+
+    if (!params.captureDir.empty()) {
+        if (params.captureObsBuilder && params.captureActionParser) {
+            // Timestamped, so restarting the bot never overwrites an earlier capture
+            std::string filePrefix = "bot" + std::to_string(_index) + "_" + std::to_string((int64_t)std::time(nullptr));
+            capture = std::make_unique<ColumnCapture>(params.captureDir, filePrefix, params.captureObsBuilder, params.captureActionParser,
+                params.obsSize, params.captureRowsPerSegment, params.captureFlushIntervalMs);
+            if (!capture->IsOpen())
+                capture.reset();
+        } else {
+            RG_LOG("Capture needs its own obs builder and action parser (captureObsBuilder, captureActionParser), capture disabled");
+        }
+    }
+
+    if (params.useLatestPacketMailbox)
+        tickThread = std::thread(&RLBotBot::TickThreadLoop, this);
 }
 
 RLBotBot::~RLBotBot() {
+    if (tickThread.joinable()) {
+        packetMailbox.Interrupt();
+        tickThread.join();
+    }
+
+    if (droppedPackets > 0)
+        RG_LOG("RLBot bot " << index << " dropped " << droppedPackets << " stale packet(s) in total");
+}
+
+void RLBotBot::TickThreadLoop() {
+    while (auto queued = packetMailbox.WaitTake()) {
+        rlbot::Controller output = ProcessPacket(queued->packet);
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            latestOutput = output;
+            latestOutputSeq = queued->seq;
+        }
+        outputCV.notify_all();
+    }
 }
 
 void RLBotBot::UpdateBallHitInfo(Player& player, PlayerInternalState& internalState, 
-                                  float curTime, const rlbot::flat::Touch* latestTouch) {
+                                  float curTime, const RLBotPacket::Touch* latestTouch) {
     // Update ball hit info if this player touched the ball
-    if (latestTouch && latestTouch->playerIndex() == player.index) {
-        float timeSinceTouch = curTime - latestTouch->gameSeconds();
+    if (latestTouch && latestTouch->playerIndex == player.index) {
+        float timeSinceTouch = curTime - latestTouch->gameSeconds;
         
         // Only update if this is a recent touch
         if (timeSinceTouch < 0.1f && gs.lastTickCount > internalState.ballHitInfo.tickCountWhenHit) {
@@ -52,7 +167,7 @@ void RLBotBot::UpdateBallHitInfo(Player& player, PlayerInternalState& internalSt
             
             // Calculate relative position on ball
             Vec ballPos = gs.ball.pos;
-            Vec touchLocation = ToVec(latestTouch->location());
+            Vec touchLocation = latestTouch->location;
             internalState.ballHitInfo.ballPos = ballPos;
             internalState.ballHitInfo.relativePosOnBall = touchLocation - ballPos;
             
@@ -273,27 +388,7 @@ void RLBotBot::UpdatePlayerState(Player& player, Player* prevPlayer,
             // Get the current action being applied
             Action currentAction = isLocalPlayer ? controls : prevPlayer->prevAction;
             
-            float pitch = currentAction.pitch;
-            float yaw = currentAction.yaw;
-            
-            // Normalize the dodge direction
-            Vec dodgeDir = Vec(pitch, yaw, 0);
-            float dodgeMag = dodgeDir.Length();
-            
-            if (dodgeMag > 0.1f) {
-                dodgeDir = dodgeDir.Normalized();
-                
-                // Apply deadzones (< 0.1 becomes 0)
-                if (std::abs(dodgeDir.x) < 0.1f) dodgeDir.x = 0;
-                if (std::abs(dodgeDir.y) < 0.1f) dodgeDir.y = 0;
-                
-                // Calculate relative flip torque: flipRelTorque = (-yaw, pitch, 0)
-                // This matches RocketSim's calculation
-                internalState.flipRelTorque = Vec(-dodgeDir.y, dodgeDir.x, 0);
-            } else {
-                // Neutral flip (straight up double jump) - no flip torque
-                internalState.flipRelTorque = Vec(0, 0, 0);
-            }
+            internalState.flipRelTorque = CalcFlipRelTorque(currentAction.pitch, currentAction.yaw);
         }
     }
     
@@ -317,60 +412,62 @@ void RLBotBot::UpdatePlayerState(Player& player, Player* prevPlayer,
     // Note: Don't track hadWheelContactLastFrame since Player doesn't have hasWheelContact field
 }
 
-void RLBotBot::UpdateGameState(rlbot::GameTickPacket& packet, float deltaTime, float curTime) {
+void RLBotBot::UpdateGameState(const RLBotPacket& packet, float deltaTime, float curTime) {
     
     prevGs = gs;
     gs = {};
-    gs.lastTickCount = packet->gameInfo()->frameNum();
+    gs.lastTickCount = packet.frameNum;
     gs.deltaTime = deltaTime;
 
-    PhysState ballPhys = ToPhysState(packet->ball()->physics());
-    static_cast<PhysState&>(gs.ball) = ballPhys;
-    auto latestTouch = packet->ball()->latestTouch();
+    static_cast<PhysState&>(gs.ball) = packet.ball;
+    const RLBotPacket::Touch* latestTouch = packet.hasLatestTouch ? &packet.latestTouch : nullptr;
 
-    auto boostPadStates = packet->boostPadStates();
+    // Inverted pads are left empty here, they are filled lazily from mirroredState when an orange bot needs them
+    auto& boostPadStates = packet.boostPads;
     gs.boostPads.resize(CommonValues::BOOST_LOCATIONS_AMOUNT, true);
-    gs.boostPadsInv.resize(CommonValues::BOOST_LOCATIONS_AMOUNT, true);
     gs.boostPadTimers.resize(CommonValues::BOOST_LOCATIONS_AMOUNT, 0);
-    gs.boostPadTimersInv.resize(CommonValues::BOOST_LOCATIONS_AMOUNT, 0);
+    mirroredState.Invalidate();
 
-    if (boostPadStates && boostPadStates->size() == CommonValues::BOOST_LOCATIONS_AMOUNT) {
+    if (boostPadStates.size() == CommonValues::BOOST_LOCATIONS_AMOUNT) {
         for (int i = 0; i < CommonValues::BOOST_LOCATIONS_AMOUNT; i++) {
-            gs.boostPads[i] = boostPadStates->Get(i)->isActive();
-            gs.boostPadsInv[CommonValues::BOOST_LOCATIONS_AMOUNT - i - 1] = gs.boostPads[i];
-            gs.boostPadTimers[i] = boostPadStates->Get(i)->timer();
-            gs.boostPadTimersInv[CommonValues::BOOST_LOCATIONS_AMOUNT - i - 1] = gs.boostPadTimers[i];
+            gs.boostPads[i] = boostPadStates[i].isActive;
+            gs.boostPadTimers[i] = boostPadStates[i].timer;
         }
     }
 
-    auto players = packet->players();
-    gs.players.resize(players->size());
+    auto& players = packet.cars;
+    gs.players.resize(players.size());
+    prevPlayerPtrs.resize(players.size());
     
-    for (int i = 0; i < players->size(); i++) {
-        auto playerInfo = players->Get(i);
+    for (int i = 0; i < players.size(); i++) {
+        auto& playerInfo = players[i];
         Player& player = gs.players[i];
-        Player* prevPlayer = (prevGs.players.size() > i && prevGs.players[i].carId == playerInfo->spawnId()) 
+        Player* prevPlayer = (prevGs.players.size() > i && prevGs.players[i].carId == playerInfo.spawnId) 
                             ? &prevGs.players[i] : nullptr;
         PlayerInternalState& internalState = internalPlayerStates[i];
 
         // Basic physics state
-        static_cast<PhysState&>(player) = ToPhysState(playerInfo->physics());
+        static_cast<PhysState&>(player) = playerInfo.phys;
         
         // Basic player info from RLBot
-        player.carId = playerInfo->spawnId();
-        player.team = (Team)playerInfo->team();
-        player.boost = playerInfo->boost();
-        player.isDemoed = playerInfo->isDemolished();
-        player.isOnGround = playerInfo->hasWheelContact();
-        player.hasJumped = playerInfo->jumped();
-        player.hasDoubleJumped = playerInfo->doubleJumped();
-        player.isSupersonic = playerInfo->isSupersonic();
+        player.carId = playerInfo.spawnId;
+        player.team = (Team)playerInfo.team;
+        player.boost = playerInfo.boost;
+        player.isDemoed = playerInfo.isDemolished;
+        player.isOnGround = playerInfo.hasWheelContact;
+        player.hasJumped = playerInfo.jumped;
+        player.hasDoubleJumped = playerInfo.doubleJumped;
+        player.isSupersonic = playerInfo.isSupersonic;
         player.index = i;
         player.prev = prevPlayer;
+        prevPlayerPtrs[i] = prevPlayer;
 
         // Update comprehensive state tracking (1:1 with RocketSim)
-        bool isLocalPlayer = (i == index);
-        UpdatePlayerState(player, prevPlayer, internalState, deltaTime, isLocalPlayer);
+        // With the state kernel, every car is done at once after this loop
+        if (!params.useStateKernel) {
+            bool isLocalPlayer = (i == index);
+            UpdatePlayerState(player, prevPlayer, internalState, deltaTime, isLocalPlayer);
+        }
         
         // Update ball hit info
         UpdateBallHitInfo(player, internalState, curTime, latestTouch);
@@ -378,8 +475,8 @@ void RLBotBot::UpdateGameState(rlbot::GameTickPacket& packet, float deltaTime, f
         player.ballTouchedStep = false;
         player.ballTouchedTick = false;
         
-        if (latestTouch && latestTouch->playerIndex() == i) {
-            float timeSinceTouch = curTime - latestTouch->gameSeconds();
+        if (latestTouch && latestTouch->playerIndex == i) {
+            float timeSinceTouch = curTime - latestTouch->gameSeconds;
             
             // Step touch: within the current step's time window
             if (timeSinceTouch < (params.tickSkip * CommonValues::TICK_TIME) + 0.01f) {
@@ -396,9 +493,31 @@ void RLBotBot::UpdateGameState(rlbot::GameTickPacket& packet, float deltaTime, f
         }
     }
     
+    if (params.useStateKernel) {
+        if (params.verifyStateKernel) {
+            referencePlayers = gs.players;
+            for (int i = 0; i < referencePlayers.size(); i++)
+                UpdatePlayerState(referencePlayers[i], prevPlayerPtrs[i], internalPlayerStates[i], deltaTime, i == index);
+        }
+
+        stateKernel.Step(gs.players, prevPlayerPtrs, deltaTime, gs.lastTickCount, index, controls);
+
+        if (params.verifyStateKernel) {
+            for (int i = 0; i < referencePlayers.size(); i++) {
+                const char* mismatch = FindTrackedStateMismatch(referencePlayers[i], gs.players[i]);
+                if (mismatch) {
+                    // Only log the first few, the states stay diverged after that
+                    if (stateKernelMismatches < 10)
+                        RG_LOG("State kernel mismatch on frame " << packet.frameNum << ", player " << i << ": " << mismatch);
+                    stateKernelMismatches++;
+                }
+            }
+        }
+    }
+
     gs.goalScored = false;
     for (int i = 0; i < 2; i++) {
-        int currentScore = packet->teams()->Get(i)->score();
+        int currentScore = packet.teamScores[i];
         if (currentScore > lastTeamScores[i]) {
             gs.goalScored = true;
         }
@@ -407,36 +526,82 @@ void RLBotBot::UpdateGameState(rlbot::GameTickPacket& packet, float deltaTime, f
 }
 
 rlbot::Controller RLBotBot::GetOutput(rlbot::GameTickPacket gameTickPacket) {
+    RLBotPacket packet = RLBotPacket::FromFlat(gameTickPacket);
+
+    if (packetRecorder)
+        packetRecorder->Write(packet);
+
+    if (!params.useLatestPacketMailbox)
+        return ProcessPacket(packet);
+
+    int frameNum = packet.frameNum;
+    uint64_t seq = ++publishedPackets;
+    if (packetMailbox.Publish(std::make_unique<QueuedPacket>(QueuedPacket{ std::move(packet), seq })))
+        droppedPackets++;
+
+    // Report drops at most every 30 seconds of game time
+    if (frameNum - lastDropReportFrame >= 120 * 30 || frameNum < lastDropReportFrame) {
+        if (droppedPackets > reportedDroppedPackets) {
+            RG_LOG("RLBot bot " << index << " dropped " << (droppedPackets - reportedDroppedPackets)
+                << " stale packet(s) (" << droppedPackets << " total)");
+            reportedDroppedPackets = droppedPackets;
+        }
+        lastDropReportFrame = frameNum;
+    }
+
+    // Give the tick thread a short window to finish this packet, otherwise fall back to the last controls
+    std::unique_lock<std::mutex> lock(outputMutex);
+    outputCV.wait_for(lock, std::chrono::duration<float, std::milli>(params.mailboxWaitMs),
+        [&] { return latestOutputSeq >= seq; });
+    return latestOutput;
+}
 
-    float curTime = gameTickPacket->gameInfo()->secondsElapsed();
+Action RLBotBot::InferPolicyAction(const Player& localPlayer) {
+    if (!shadowEval)
+        return params.inferUnit->InferAction(localPlayer, gs, params.deterministic);
+
+    // Time only inference, so the shadow evaluator compares like with like when checking the candidate isn't slowing us down
+    shadowEval->BeginPrimaryInference();
+    auto startTime = std::chrono::steady_clock::now();
+    Action result = params.inferUnit->InferAction(localPlayer, gs, params.deterministic);
+    shadowEval->EndPrimaryInference(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+    return result;
+}
+
+rlbot::Controller RLBotBot::ProcessPacket(const RLBotPacket& packet) {
+
+    // Whichever thread processes packets is the tick thread
+    if (!tickThreadConfigured) {
+        tickThreadConfigured = true;
+        RLBotAffinity::ApplyTickThreadSettings(params.threads, params.cores);
+    }
+
+    float curTime = packet.secondsElapsed;
     if (prevTime == 0) prevTime = curTime;
     float deltaTime = curTime - prevTime;
     prevTime = curTime;
 
-    int ticksElapsed = (ticks == -1) ? params.tickSkip : roundf(deltaTime * 120);
+    // Count ticks from frame numbers, so frames we never saw (dropped or skipped packets) are still accounted for
+    int ticksElapsed = (ticks == -1) ? params.tickSkip : RS_MAX(packet.frameNum - prevFrameNum, 0);
+    prevFrameNum = packet.frameNum;
 
     // If no time has passed, return previous controls
-    if (ticksElapsed == 0 && ticks != -1) {
-        rlbot::Controller output_controller = {};
-        output_controller.throttle = controls.throttle;
-        output_controller.steer = controls.steer;
-        output_controller.pitch = controls.pitch;
-        output_controller.yaw = controls.yaw;
-        output_controller.roll = controls.roll;
-        output_controller.jump = controls.jump != 0;
-        output_controller.boost = controls.boost != 0;
-        output_controller.handbrake = controls.handbrake != 0;
-        return output_controller;
-    }
+    if (ticksElapsed == 0 && ticks != -1)
+        return ToController(controls);
 
     last_ticks = ticks;
     ticks += ticksElapsed;
 
     // Update game state with comprehensive 1:1 RocketSim tracking
-    UpdateGameState(gameTickPacket, deltaTime, curTime);
+    UpdateGameState(packet, deltaTime, curTime);
     auto& localPlayer = gs.players[index];
     localPlayer.prevAction = controls;
 
+    // Apply the pending action once its delay has passed, before a new one can replace it
+    // This uses the un-wrapped tick count, so a skipped frame that crosses both actionDelay and tickSkip still applies it
+    if (last_ticks < params.actionDelay && ticks >= params.actionDelay)
+        controls = action;
+
     // Determine if we need new action from policy
     if (ticks >= params.tickSkip || ticks == -1) {
         ticks %= params.tickSkip;
@@ -444,29 +609,177 @@ rlbot::Controller RLBotBot::GetOutput(rlbot::GameTickPacket gameTickPacket) {
     }
 
     // Get new action from policy if needed
+    bool newAction = updateAction;
     if (updateAction) {
         updateAction = false;
-        action = params.inferUnit->InferAction(localPlayer, gs, params.deterministic);
+        auto inferStartTime = std::chrono::steady_clock::now();
+
+        // Obs builders read the inverted pads for orange players
+        if (localPlayer.team == Team::ORANGE)
+            mirroredState.FillInverted(gs);
+
+        ActionCache::Phase cachePhase = actionCache ? ActionCache::GetPhase(packet) : ActionCache::Phase::NONE;
+        if (cachePhase == ActionCache::Phase::NONE && prevCachePhase != ActionCache::Phase::NONE)
+            actionCache->ReportStats("this kickoff");
+        prevCachePhase = cachePhase;
+
+        if (cachePhase != ActionCache::Phase::NONE) {
+            actionCache->SetCheckpoint(params.checkpointHash);
+            if (!actionCache->Lookup(localPlayer, gs, action)) {
+                action = InferPolicyAction(localPlayer);
+                actionCache->Store(action);
+            }
+        } else {
+            action = InferPolicyAction(localPlayer);
+        }
+
+        if (shadowEval) {
+            float inferMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - inferStartTime).count();
+            shadowEval->Submit(packet.frameNum, index, gs, action, inferMs);
+        }
+
+        if (capture)
+            capture->Submit(packet.frameNum, index, gs, action);
     }
 
-    // Apply action delay
-    if (last_ticks < params.actionDelay && ticks >= params.actionDelay) {
+    // A new action whose delay has already passed (the first action, or frames were skipped) applies right away
+    if (newAction && ticks >= params.actionDelay)
         controls = action;
-    }
 
     // Convert to RLBot controller format
-    rlbot::Controller output_controller = {};
-    output_controller.throttle = controls.throttle;
-    output_controller.steer = controls.steer;
-    output_controller.pitch = controls.pitch;
-    output_controller.yaw = controls.yaw;
-    output_controller.roll = controls.roll;
-    output_controller.jump = controls.jump != 0;
-    output_controller.boost = controls.boost != 0;
-    output_controller.handbrake = controls.handbrake != 0; 
-    output_controller.useItem = false;
+    return ToController(controls);
+}
 
-    return output_controller;
+void RLBotBot::BenchmarkStateKernel() {
+    constexpr int PACKET_AMOUNT = 100 * 1000;
+    constexpr int REPEATS = 5;
+    constexpr int BATCH_SIZE = 64;
+
+    for (int carAmount : { 2, 6, 8 }) {
+        std::mt19937 rng(carAmount);
+        std::uniform_real_distribution<float> unitDist(-1, 1);
+        auto chance = [&](float prob) { return (unitDist(rng) * 0.5f + 0.5f) < prob; };
+
+        // Generate packets that keep hitting every transition: landings, jumps, flips, flip resets, demos, auto-flips
+        struct Frame {
+            std::vector<Player> players;
+            std::vector<Action> prevActions;
+            Action controls;
+            float deltaTime;
+        };
+        std::vector<Frame> frames(PACKET_AMOUNT);
+        std::vector<Player> cur(carAmount);
+        for (int i = 0; i < carAmount; i++) {
+            cur[i] = {};
+            cur[i].index = i;
+            cur[i].carId = i + 1;
+            cur[i].isOnGround = true;
+        }
+
+        for (auto& frame : frames) {
+            for (auto& player : cur) {
+                if (player.isOnGround) {
+                    if (chance(0.05f)) {
+                        player.isOnGround = false;
+                        player.hasJumped = chance(0.7f);
+                    }
+                    player.hasDoubleJumped = false;
+                } else {
+                    if (chance(0.03f)) {
+                        player.isOnGround = true;
+                        player.hasJumped = false;
+                    } else if (player.hasJumped && !player.hasDoubleJumped && chance(0.05f)) {
+                        player.hasDoubleJumped = true;
+                    } else if (chance(0.01f)) {
+                        // Flip reset
+                        player.hasJumped = false;
+                        player.hasDoubleJumped = false;
+                    }
+                }
+                if (chance(player.isDemoed ? 0.01f : 0.002f))
+                    player.isDemoed = !player.isDemoed;
+                if (chance(0.05f))
+                    player.isSupersonic = !player.isSupersonic;
+
+                Angle angle = Angle(unitDist(rng) * 3.14f, unitDist(rng) * 1.5f, unitDist(rng) * 3.14f);
+                player.rotMat = angle.ToRotMat();
+            }
+            frame.players = cur;
+
+            frame.prevActions.resize(carAmount);
+            for (auto& action : frame.prevActions) {
+                action = {};
+                action.pitch = unitDist(rng);
+                action.yaw = unitDist(rng);
+                action.boost = chance(0.3f);
+                action.handbrake = chance(0.1f);
+            }
+            frame.controls = frame.prevActions[0];
+            frame.deltaTime = chance(0.1f) ? (2 * CommonValues::TICK_TIME) : CommonValues::TICK_TIME;
+        }
+
+        // Runs every frame through one of the two paths, returns average nanoseconds per packet
+        // Packets are timed in batches, a clock read costs about as much as updating a car
+        auto run = [&](bool useKernel, std::vector<std::vector<Player>>& results) {
+            RLBotBot bot(0, 0, "StateKernelBenchmark", RLBotParams{});
+            results.assign(PACKET_AMOUNT, {});
+            std::vector<Player*> prevPtrs(carAmount);
+            double totalNs = 0;
+
+            for (int batchStart = 0; batchStart < PACKET_AMOUNT; batchStart += BATCH_SIZE) {
+                int batchEnd = RS_MIN(batchStart + BATCH_SIZE, PACKET_AMOUNT);
+
+                // Copied in before timing, so both paths start with the batch in cache
+                for (int f = batchStart; f < batchEnd; f++)
+                    results[f] = frames[f].players;
+
+                auto startTime = std::chrono::steady_clock::now();
+                for (int f = batchStart; f < batchEnd; f++) {
+                    Frame& frame = frames[f];
+                    std::vector<Player>& players = results[f];
+                    for (int i = 0; i < carAmount; i++)
+                        prevPtrs[i] = (f > 0) ? &results[f - 1][i] : nullptr;
+                    bot.controls = frame.controls;
+                    bot.gs.lastTickCount = f;
+
+                    if (useKernel) {
+                        bot.stateKernel.Step(players, prevPtrs, frame.deltaTime, f, 0, bot.controls);
+                    } else {
+                        for (int i = 0; i < carAmount; i++)
+                            bot.UpdatePlayerState(players[i], prevPtrs[i], bot.internalPlayerStates[i], frame.deltaTime, i == 0);
+                    }
+
+                    for (int i = 0; i < carAmount; i++)
+                        players[i].prevAction = frame.prevActions[i];
+                }
+                totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+            }
+            return totalNs / PACKET_AMOUNT;
+        };
+
+        double bestReferenceNs = 1e30, bestKernelNs = 1e30;
+        std::vector<std::vector<Player>> referenceResults, kernelResults;
+        for (int repeat = 0; repeat < REPEATS; repeat++) {
+            bestReferenceNs = RS_MIN(bestReferenceNs, run(false, referenceResults));
+            bestKernelNs = RS_MIN(bestKernelNs, run(true, kernelResults));
+        }
+
+        int mismatches = 0;
+        for (int f = 0; f < PACKET_AMOUNT; f++) {
+            for (int i = 0; i < carAmount; i++) {
+                const char* mismatch = FindTrackedStateMismatch(referenceResults[f][i], kernelResults[f][i]);
+                if (mismatch) {
+                    if (mismatches == 0)
+                        RG_LOG(" First mismatch: frame " << f << ", player " << i << ": " << mismatch);
+                    mismatches++;
+                }
+            }
+        }
+
+        RG_LOG("State kernel, " << carAmount << " cars: UpdatePlayerState() " << bestReferenceNs << "ns/packet, "
+            << "kernel " << bestKernelNs << "ns/packet (" << (bestReferenceNs / bestKernelNs) << "x), "
+            << (mismatches ? std::to_string(mismatches) + " MISMATCHING player states" : std::string("bit-identical")));
+    }
 }
 
 void RLBotClient::Run(const RLBotParams& params) {
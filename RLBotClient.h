@@ -7,8 +7,20 @@
 #include <GigaLearnCPP/Util/ModelConfig.h>
 
 #include <RLGymCPP/Framework.h>
+#include "RLBotActionCache.h"
+#include "RLBotAffinity.h"
+#include "RLBotCapture.h"
+#include "RLBotMailbox.h"
+#include "RLBotMirroredState.h"
+#include "RLBotPacketLog.h"
+#include "RLBotShadowEval.h"
+#include "RLBotStateKernel.h"
 #include <memory>
 #include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace RLBotConst {
     // Physics constants
@@ -133,6 +145,46 @@ struct RLBotParams {
     bool deterministic = false;
     bool useGPU = true;
 
+    // Decouple packet reads from processing: packets go through a latest-wins mailbox to a dedicated tick thread,
+    //  so an overrunning GetOutput() drops stale packets instead of working through them one by one
+    bool useLatestPacketMailbox = false;
+    // How long GetOutput() waits for the tick thread to finish the newest packet before returning the last controls
+    float mailboxWaitMs = 4.f;
+
+    // Core pinning, inference thread budget and priority (see RLBotAffinity.h)
+    RLBotThreadParams threads;
+    std::vector<int> cores; // Physical cores leased to this process at startup (see CoreLease::GetCores()), empty if none
+
+    // Reuse actions for exactly repeating kickoff/reset states instead of running inference (deterministic only)
+    bool useActionCache = false;
+    float actionCacheQuantizeStep = 1e-4f;
+
+    // Hash of the loaded checkpoint (see RLBotPlatform::HashCheckpoint()), anything cached per checkpoint is keyed on it
+    uint64_t checkpointHash = 0;
+
+    // Candidate checkpoint to shadow-evaluate on the same states (see RLBotShadowEval.h), nullptr to disable
+    GGL::InferUnit* shadowInferUnit = nullptr;
+    // Fraction of one core the candidate's single inference thread may use
+    float shadowCpuBudget = 0.25f;
+
+    // Track every car's timers in one branch-light pass (see RLBotStateKernel.h) instead of UpdatePlayerState() per car
+    bool useStateKernel = false;
+    // Also run UpdatePlayerState() every packet and log any result that isn't bit-identical
+    bool verifyStateKernel = false;
+
+    // Folder to record every received packet into ("packets_bot<index>.bin"), for replaying with --replay, empty to disable
+    std::string recordPacketsDir = "";
+
+    // Folder to capture every policy step into (obs, action index, tick, team; see RLBotCapture.h), empty to disable
+    std::string captureDir = "";
+    // The capture's own obs builder and action parser, since it builds rows on another thread
+    RLGC::ObsBuilder* captureObsBuilder = nullptr;
+    RLGC::ActionParser* captureActionParser = nullptr;
+    // Rows per capture segment, a new set of files is started after that many
+    int captureRowsPerSegment = 1 << 16;
+    // How often captured rows are written back to disk
+    int captureFlushIntervalMs = 1000;
+
     RLGC::ObsBuilder* obsBuilder = nullptr;
     RLGC::ActionParser* actionParser = nullptr;
     GGL::InferUnit* inferUnit = nullptr;
@@ -142,6 +194,48 @@ struct RLBotParams {
     GGL::PartialModelConfig sharedHeadConfig;
 };
 
+// Plain copy of the packet fields the bot reads
+// Unlike rlbot::GameTickPacket, it owns its data, so it can be handed to another thread or kept around
+struct RLBotPacket {
+    int frameNum = 0;
+    float secondsElapsed = 0;
+    bool isKickoffPause = false;
+    bool isRoundActive = false;
+
+    RLGC::PhysState ball = {};
+
+    struct Touch {
+        int playerIndex = -1;
+        float gameSeconds = 0;
+        Vec location = Vec(0, 0, 0);
+    };
+    bool hasLatestTouch = false;
+    Touch latestTouch = {};
+
+    struct BoostPad {
+        bool isActive = true;
+        float timer = 0;
+    };
+    std::vector<BoostPad> boostPads;
+
+    struct Car {
+        RLGC::PhysState phys = {};
+        uint32_t spawnId = 0;
+        int team = 0;
+        int boost = 0;
+        bool isDemolished = false;
+        bool hasWheelContact = false;
+        bool jumped = false;
+        bool doubleJumped = false;
+        bool isSupersonic = false;
+    };
+    std::vector<Car> cars;
+
+    int teamScores[2] = {0, 0};
+
+    static RLBotPacket FromFlat(rlbot::GameTickPacket& packet);
+};
+
 class RLBotBot : public rlbot::Bot {
 public:
     RLBotParams params;
@@ -152,6 +246,8 @@ public:
 
     bool updateAction = true;
     float prevTime = 0;
+    int prevFrameNum = -1;
+    bool tickThreadConfigured = false;
     int ticks = -1;
     int last_ticks = -1;
 
@@ -246,7 +342,10 @@ public:
         }
     };
     
+    // With params.useStateKernel, the per-car timers are tracked in stateKernel instead
+    // (internalPlayerStates then only keeps ball hit and touch info, unless params.verifyStateKernel is set)
     std::map<int, PlayerInternalState> internalPlayerStates;
+    PlayerStateKernel stateKernel;
     int lastTeamScores[2] = {0, 0};
 
     RLBotBot(int _index, int _team, std::string _name, const RLBotParams& params);
@@ -254,13 +353,54 @@ public:
 
     rlbot::Controller GetOutput(rlbot::GameTickPacket gameTickPacket) override;
 
+    // Runs one packet through state tracking and the policy
+    rlbot::Controller ProcessPacket(const RLBotPacket& packet);
+
+    // Times UpdatePlayerState() against PlayerStateKernel at 2, 6 and 8 cars on generated packets,
+    //  checking that both give bit-identical results
+    static void BenchmarkStateKernel();
+
 private:
-    void UpdateGameState(rlbot::GameTickPacket& packet, float deltaTime, float curTime);
+    MirroredStateView mirroredState;
+
+    std::unique_ptr<ActionCache> actionCache;
+    ActionCache::Phase prevCachePhase = ActionCache::Phase::NONE;
+
+    std::unique_ptr<ShadowEvaluator> shadowEval;
+    std::unique_ptr<PacketRecorder> packetRecorder;
+
+    std::unique_ptr<ColumnCapture> capture;
+
+    std::vector<RLGC::Player*> prevPlayerPtrs;
+    std::vector<RLGC::Player> referencePlayers;
+    uint64_t stateKernelMismatches = 0;
+
+    // Latest-wins receive path (see RLBotParams::useLatestPacketMailbox)
+    // Packets are numbered as they're published, frame numbers restart with every match
+    struct QueuedPacket {
+        RLBotPacket packet;
+        uint64_t seq;
+    };
+    LatestMailbox<QueuedPacket> packetMailbox;
+    std::thread tickThread;
+    std::mutex outputMutex;
+    std::condition_variable outputCV;
+    rlbot::Controller latestOutput = {};
+    uint64_t publishedPackets = 0;
+    uint64_t latestOutputSeq = 0;
+    uint64_t droppedPackets = 0;
+    uint64_t reportedDroppedPackets = 0;
+    int lastDropReportFrame = 0;
+
+    void TickThreadLoop();
+    RLGC::Action InferPolicyAction(const RLGC::Player& localPlayer);
+
+    void UpdateGameState(const RLBotPacket& packet, float deltaTime, float curTime);
     void UpdatePlayerState(RLGC::Player& player, RLGC::Player* prevPlayer, 
                           PlayerInternalState& internalState, 
                           float deltaTime, bool isLocalPlayer);
     void UpdateBallHitInfo(RLGC::Player& player, PlayerInternalState& internalState, 
-                          float curTime, const rlbot::flat::Touch* latestTouch);
+                          float curTime, const RLBotPacket::Touch* latestTouch);
 };
 
 namespace RLBotClient {
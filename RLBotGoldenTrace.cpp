@@ -0,0 +1,277 @@
+#include "RLBotGoldenTrace.h"
+#include "RLBotClient.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+using namespace RLGC;
+
+struct TracedPlayerField {
+    const char* name;
+    float(*get)(const Player& player);
+};
+
+#define PLAYER_FIELD(name, field) { name, [](const Player& player) { return (float)player.field; } }
+static const TracedPlayerField TRACED_PLAYER_FIELDS[] = {
+    PLAYER_FIELD("boost", boost),
+    PLAYER_FIELD("isOnGround", isOnGround),
+    PLAYER_FIELD("hasJumped", hasJumped),
+    PLAYER_FIELD("hasDoubleJumped", hasDoubleJumped),
+    PLAYER_FIELD("isDemoed", isDemoed),
+    PLAYER_FIELD("isSupersonic", isSupersonic),
+    PLAYER_FIELD("supersonicTime", supersonicTime),
+    PLAYER_FIELD("timeSpentBoosting", timeSpentBoosting),
+    PLAYER_FIELD("handbrakeVal", handbrakeVal),
+    PLAYER_FIELD("demoRespawnTimer", demoRespawnTimer),
+    PLAYER_FIELD("carContactOtherID", carContact.otherCarID),
+    PLAYER_FIELD("carContactCooldown", carContact.cooldownTimer),
+    PLAYER_FIELD("airTime", airTime),
+    PLAYER_FIELD("jumpTime", jumpTime),
+    PLAYER_FIELD("flipTime", flipTime),
+    PLAYER_FIELD("airTimeSinceJump", airTimeSinceJump),
+    PLAYER_FIELD("isJumping", isJumping),
+    PLAYER_FIELD("isFlipping", isFlipping),
+    PLAYER_FIELD("hasFlipped", hasFlipped),
+    PLAYER_FIELD("flipRelTorqueX", flipRelTorque.x),
+    PLAYER_FIELD("flipRelTorqueY", flipRelTorque.y),
+    PLAYER_FIELD("flipRelTorqueZ", flipRelTorque.z),
+    PLAYER_FIELD("isAutoFlipping", isAutoFlipping),
+    PLAYER_FIELD("autoFlipTimer", autoFlipTimer),
+    PLAYER_FIELD("autoFlipTorqueScale", autoFlipTorqueScale),
+    PLAYER_FIELD("ballTouchedStep", ballTouchedStep),
+    PLAYER_FIELD("ballTouchedTick", ballTouchedTick),
+};
+#undef PLAYER_FIELD
+
+static const char* CONTROLLER_COLUMNS[] = { "throttle", "steer", "pitch", "yaw", "roll", "jump", "boost", "handbrake" };
+
+bool GoldenTrace::Save(const std::filesystem::path& path) const {
+    std::ofstream out(path);
+    if (!out.good()) {
+        RG_LOG("GoldenTrace: Failed to open " << path << " for writing");
+        return false;
+    }
+
+    for (size_t i = 0; i < columns.size(); i++)
+        out << (i ? "," : "") << columns[i];
+    out << "\n";
+
+    out.precision(9); // Enough for any float to read back bit-identical
+    for (auto& row : rows) {
+        for (size_t i = 0; i < row.size(); i++)
+            out << (i ? "," : "") << row[i];
+        out << "\n";
+    }
+
+    return out.good();
+}
+
+bool GoldenTrace::Load(const std::filesystem::path& path, GoldenTrace& outTrace) {
+    std::ifstream in(path);
+    if (!in.good()) {
+        RG_LOG("GoldenTrace: Failed to open " << path);
+        return false;
+    }
+
+    outTrace.columns.clear();
+    outTrace.rows.clear();
+
+    std::string line, cell;
+    if (!std::getline(in, line))
+        return false;
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    std::stringstream header(line);
+    while (std::getline(header, cell, ','))
+        outTrace.columns.push_back(cell);
+
+    while (std::getline(in, line)) {
+        if (line.empty())
+            continue;
+
+        std::vector<float> row;
+        row.reserve(outTrace.columns.size());
+        const char* cur = line.c_str();
+        while (*cur) {
+            char* end;
+            row.push_back(std::strtof(cur, &end));
+            if (end == cur || (*end != ',' && *end != '\0' && *end != '\r')) {
+                RG_LOG("GoldenTrace: Bad value on row " << outTrace.rows.size() << " of " << path);
+                return false;
+            }
+            cur = (*end == ',') ? end + 1 : end + (*end == '\r');
+        }
+
+        if (row.size() != outTrace.columns.size()) {
+            RG_LOG("GoldenTrace: Row " << outTrace.rows.size() << " of " << path << " has " << row.size()
+                << " values, expected " << outTrace.columns.size());
+            return false;
+        }
+        outTrace.rows.push_back(std::move(row));
+    }
+
+    return true;
+}
+
+float GoldenTolerances::Get(const std::string& column) const {
+    auto itr = perColumn.find(column);
+    return (itr != perColumn.end()) ? itr->second : 0;
+}
+
+GoldenTrace GoldenTraceHarness::Replay(const PacketLog& log, RLBotParams params, GoldenThroughput& outThroughput) {
+    // Same bot logic, minus everything that would make the replay depend on timing or write elsewhere
+    params.deterministic = true;
+    params.useLatestPacketMailbox = false;
+    params.shadowInferUnit = nullptr;
+    params.recordPacketsDir.clear();
+    params.captureDir.clear();
+
+    RLBotBot bot(log.botIndex, log.botTeam, "GoldenTraceReplay", params);
+
+    GoldenTrace trace = {};
+    trace.columns = { "frame", "player" };
+    for (const char* column : CONTROLLER_COLUMNS)
+        trace.columns.push_back(column);
+    for (auto& field : TRACED_PLAYER_FIELDS)
+        trace.columns.push_back(field.name);
+
+    std::vector<double> tickMs;
+    tickMs.reserve(log.packets.size());
+
+    for (auto& packet : log.packets) {
+        auto startTime = std::chrono::steady_clock::now();
+        rlbot::Controller output = bot.ProcessPacket(packet);
+        tickMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+
+        float controllerVals[] = {
+            output.throttle, output.steer, output.pitch, output.yaw, output.roll,
+            (float)output.jump, (float)output.boost, (float)output.handbrake
+        };
+
+        for (auto& player : bot.gs.players) {
+            std::vector<float> row;
+            row.reserve(trace.columns.size());
+            row.push_back((float)packet.frameNum);
+            row.push_back((float)player.index);
+            row.insert(row.end(), std::begin(controllerVals), std::end(controllerVals));
+            for (auto& field : TRACED_PLAYER_FIELDS)
+                row.push_back(field.get(player));
+            trace.rows.push_back(std::move(row));
+        }
+    }
+
+    outThroughput = {};
+    outThroughput.ticks = tickMs.size();
+    if (!tickMs.empty()) {
+        double totalMs = 0;
+        for (double ms : tickMs)
+            totalMs += ms;
+        outThroughput.meanMs = totalMs / tickMs.size();
+        outThroughput.ticksPerSec = tickMs.size() / (totalMs / 1000);
+
+        auto itr = tickMs.begin() + (tickMs.size() * 99 / 100);
+        std::nth_element(tickMs.begin(), itr, tickMs.end());
+        outThroughput.p99Ms = *itr;
+    }
+
+    return trace;
+}
+
+bool GoldenTraceHarness::Compare(const GoldenTrace& golden, const GoldenTrace& current, const GoldenTolerances& tolerances) {
+    if (golden.columns != current.columns) {
+        RG_LOG("GoldenTrace: Columns differ from the golden trace, it needs to be re-recorded");
+        return false;
+    }
+
+    std::vector<float> columnTolerances;
+    for (auto& column : golden.columns)
+        columnTolerances.push_back(tolerances.Get(column));
+
+    size_t rowAmount = RS_MIN(golden.rows.size(), current.rows.size());
+    size_t divergentRows = 0;
+    int64_t firstDivergentRow = -1;
+    size_t firstDivergentColumn = 0;
+    for (size_t r = 0; r < rowAmount; r++) {
+        auto& goldenRow = golden.rows[r];
+        auto& currentRow = current.rows[r];
+        for (size_t c = 0; c < goldenRow.size(); c++) {
+            // Written as a negated <= so NaN on either side counts as divergent, unless both are NaN
+            bool bothNaN = std::isnan(goldenRow[c]) && std::isnan(currentRow[c]);
+            if (!bothNaN && !(std::abs(goldenRow[c] - currentRow[c]) <= columnTolerances[c])) {
+                if (firstDivergentRow == -1) {
+                    firstDivergentRow = r;
+                    firstDivergentColumn = c;
+                }
+                divergentRows++;
+                break;
+            }
+        }
+    }
+
+    if (firstDivergentRow != -1) {
+        auto& goldenRow = golden.rows[firstDivergentRow];
+        auto& currentRow = current.rows[firstDivergentRow];
+        RG_LOG("GoldenTrace: First divergence at frame " << (int64_t)goldenRow[0] << ", player " << (int)goldenRow[1]
+            << " (row " << firstDivergentRow << "): " << golden.columns[firstDivergentColumn]
+            << " is " << currentRow[firstDivergentColumn] << ", golden is " << goldenRow[firstDivergentColumn]
+            << " (tolerance " << columnTolerances[firstDivergentColumn] << ")");
+
+        // Every other column that also differs on that row, to help tell the cause from the consequences
+        for (size_t c = firstDivergentColumn + 1; c < goldenRow.size(); c++) {
+            if (goldenRow[c] != currentRow[c])
+                RG_LOG(" " << golden.columns[c] << ": " << currentRow[c] << ", golden is " << goldenRow[c]);
+        }
+
+        RG_LOG("GoldenTrace: " << divergentRows << "/" << rowAmount << " rows diverged");
+    }
+
+    if (golden.rows.size() != current.rows.size())
+        RG_LOG("GoldenTrace: Trace has " << current.rows.size() << " rows, golden trace has " << golden.rows.size());
+
+    return firstDivergentRow == -1 && golden.rows.size() == current.rows.size();
+}
+
+bool GoldenTraceHarness::Run(const std::filesystem::path& packetLogPath, const std::filesystem::path& goldenPath,
+    const RLBotParams& params, const GoldenTolerances& tolerances, bool updateGolden) {
+
+    PacketLog log;
+    if (!PacketLog::Read(packetLogPath, log))
+        return false;
+    RG_LOG("GoldenTrace: Replaying " << log.packets.size() << " packets from " << packetLogPath
+        << " as bot " << log.botIndex << "...");
+
+    GoldenThroughput throughput;
+    GoldenTrace trace = Replay(log, params, throughput);
+
+    RG_LOG("GoldenTrace: " << throughput.ticks << " ticks, " << (int64_t)throughput.ticksPerSec << " ticks/s, "
+        << throughput.meanMs << "ms mean, " << throughput.p99Ms << "ms p99");
+
+    bool recordGolden = updateGolden || !std::filesystem::exists(goldenPath);
+    bool passed;
+    if (recordGolden) {
+        passed = trace.Save(goldenPath);
+        if (passed)
+            RG_LOG("GoldenTrace: Recorded golden trace to " << goldenPath);
+    } else {
+        GoldenTrace golden;
+        passed = GoldenTrace::Load(goldenPath, golden) && Compare(golden, trace, tolerances);
+        RG_LOG("GoldenTrace: " << (passed ? "Matches" : "DIVERGED from") << " the golden trace at " << goldenPath);
+    }
+
+    // Keep a history of throughput next to the golden trace, so each run can be compared to earlier ones
+    std::filesystem::path throughputPath = goldenPath;
+    throughputPath += ".throughput.csv";
+    bool writeHeader = !std::filesystem::exists(throughputPath);
+    std::ofstream throughputOut(throughputPath, std::ios::app);
+    if (writeHeader)
+        throughputOut << "time,kind,ticks,ticks_per_sec,mean_ms,p99_ms,passed\n";
+    throughputOut << (int64_t)std::time(nullptr) << "," << (recordGolden ? "golden" : "compare") << ","
+        << throughput.ticks << "," << throughput.ticksPerSec << "," << throughput.meanMs << ","
+        << throughput.p99Ms << "," << passed << "\n";
+
+    return passed;
+}
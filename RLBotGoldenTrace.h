@@ -0,0 +1,53 @@
+#pragma once
+
+#include "RLBotPacketLog.h"
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+struct RLBotParams;
+
+// Trace of what the bot did over a packet log: one row per car per packet, holding the bot's controller output
+//  for that packet and the car's tracked Player fields
+// A golden trace is recorded once on a known-good build, then every new build replays the same packets and is
+//  compared against it, so optimizations that change the bot's behavior are caught along with their speed
+struct GoldenTrace {
+    // Always starts with "frame" and "player"
+    std::vector<std::string> columns;
+    // Stored as floats, every traced value is a float, bool or small integer
+    std::vector<std::vector<float>> rows;
+
+    // CSV, with enough digits for every float to read back exactly
+    bool Save(const std::filesystem::path& path) const;
+    static bool Load(const std::filesystem::path& path, GoldenTrace& outTrace);
+};
+
+struct GoldenTolerances {
+    // Maximum absolute difference allowed per column, columns not listed must match exactly
+    std::map<std::string, float> perColumn;
+
+    float Get(const std::string& column) const;
+};
+
+struct GoldenThroughput {
+    int ticks = 0;
+    double ticksPerSec = 0;
+    double meanMs = 0, p99Ms = 0;
+};
+
+namespace GoldenTraceHarness {
+    // Replays every packet through a new bot with these params, in deterministic mode, and traces it
+    // Only the bot's own processing is timed, not the tracing
+    GoldenTrace Replay(const PacketLog& log, RLBotParams params, GoldenThroughput& outThroughput);
+
+    // Logs the first divergent tick and returns false if the traces differ beyond the tolerances
+    bool Compare(const GoldenTrace& golden, const GoldenTrace& current, const GoldenTolerances& tolerances);
+
+    // Replays the packet log, then records a new golden trace if none exists yet (or updateGolden is set),
+    //  otherwise compares against it
+    // Throughput is appended to "<golden trace>.throughput.csv" either way
+    // Returns false if the replay failed or diverged from the golden trace
+    bool Run(const std::filesystem::path& packetLogPath, const std::filesystem::path& goldenPath,
+        const RLBotParams& params, const GoldenTolerances& tolerances, bool updateGolden);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Single-slot, latest-wins mailbox
+// The producer always overwrites whatever is in the slot, so a slow consumer only ever sees the newest item
+// Ownership moves through an atomic pointer exchange, so neither side ever takes a lock
+template <typename T>
+class LatestMailbox {
+public:
+    LatestMailbox() = default;
+    LatestMailbox(const LatestMailbox&) = delete;
+    LatestMailbox& operator=(const LatestMailbox&) = delete;
+
+    ~LatestMailbox() {
+        delete slot.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    // Returns true if an item that was never taken got overwritten (i.e. dropped)
+    bool Publish(std::unique_ptr<T> item) {
+        T* old = slot.exchange(item.release(), std::memory_order_acq_rel);
+        seq.fetch_add(1, std::memory_order_release);
+        seq.notify_one();
+
+        if (old) {
+            delete old;
+            return true;
+        }
+        return false;
+    }
+
+    // Non-blocking, returns nullptr if the slot is empty
+    std::unique_ptr<T> Take() {
+        return std::unique_ptr<T>(slot.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+    // Blocks until an item is available, returns nullptr once Interrupt() has been called
+    std::unique_ptr<T> WaitTake() {
+        while (true) {
+            uint32_t curSeq = seq.load(std::memory_order_acquire);
+            if (interrupted.load(std::memory_order_acquire))
+                return nullptr;
+
+            if (auto item = Take())
+                return item;
+
+            seq.wait(curSeq, std::memory_order_acquire);
+        }
+    }
+
+    void Interrupt() {
+        interrupted.store(true, std::memory_order_release);
+        seq.fetch_add(1, std::memory_order_release);
+        seq.notify_all();
+    }
+
+private:
+    std::atomic<T*> slot = nullptr;
+    std::atomic<uint32_t> seq = 0;
+    std::atomic<bool> interrupted = false;
+};
+
+// Bounded single-producer, single-consumer queue
+// Unlike LatestMailbox, nothing is ever overwritten: the producer only drops an item when the ring is full
+// Each side only advances its own position, so neither side ever takes a lock
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) : items(capacity) {}
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only, returns false (and drops the item) if the ring is full
+    bool Push(T item) {
+        uint64_t write = writePos.load(std::memory_order_relaxed);
+        if (write - readPos.load(std::memory_order_acquire) >= items.size())
+            return false;
+
+        items[write % items.size()] = std::move(item);
+        writePos.store(write + 1, std::memory_order_release);
+        seq.fetch_add(1, std::memory_order_release);
+        seq.notify_one();
+        return true;
+    }
+
+    // Consumer only, blocks until an item is available
+    // Returns false once Interrupt() has been called and every item before it has been popped
+    bool WaitPop(T& outItem) {
+        uint64_t read = readPos.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t curSeq = seq.load(std::memory_order_acquire);
+            if (writePos.load(std::memory_order_acquire) != read)
+                break;
+            if (interrupted.load(std::memory_order_acquire))
+                return false;
+
+            seq.wait(curSeq, std::memory_order_acquire);
+        }
+
+        outItem = std::move(items[read % items.size()]);
+        readPos.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Interrupt() {
+        interrupted.store(true, std::memory_order_release);
+        seq.fetch_add(1, std::memory_order_release);
+        seq.notify_all();
+    }
+
+private:
+    std::vector<T> items;
+    std::atomic<uint64_t> writePos = 0, readPos = 0;
+    std::atomic<uint32_t> seq = 0;
+    std::atomic<bool> interrupted = false;
+};
@@ -0,0 +1,21 @@
+#include "RLBotMirroredState.h"
+
+using namespace RLGC;
+
+void MirroredStateView::FillInverted(GameState& state) {
+    if (valid)
+        return;
+
+    // Pad indices are sorted by position, so mirroring the field just reverses them
+    size_t padAmount = state.boostPads.size();
+    state.boostPadsInv.resize(padAmount);
+    for (size_t i = 0; i < padAmount; i++)
+        state.boostPadsInv[padAmount - i - 1] = state.boostPads[i];
+
+    padAmount = state.boostPadTimers.size();
+    state.boostPadTimersInv.resize(padAmount);
+    for (size_t i = 0; i < padAmount; i++)
+        state.boostPadTimersInv[padAmount - i - 1] = state.boostPadTimers[i];
+
+    valid = true;
+}
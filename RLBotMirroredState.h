@@ -0,0 +1,19 @@
+#pragma once
+
+#include <RLGymCPP/Framework.h>
+#include <RLGymCPP/Gamestates/GameState.h>
+
+// Lazily fills the team-mirrored parts of a GameState that obs builders read (the inverted boost pads)
+// Nothing is mirrored until an orange bot needs it, so blue bots never pay for it,
+//  and filling it again within the same frame is free
+class MirroredStateView {
+public:
+    // Mark the inverted pads stale, call once per new GameState
+    void Invalidate() { valid = false; }
+
+    // Write state.boostPadsInv and state.boostPadTimersInv, if they aren't up to date yet this frame
+    void FillInverted(RLGC::GameState& state);
+
+private:
+    bool valid = false;
+};
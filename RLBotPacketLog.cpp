@@ -0,0 +1,161 @@
+#include "RLBotPacketLog.h"
+#include "RLBotClient.h"
+
+using namespace RLGC;
+
+template<typename T>
+static void WriteVal(std::ofstream& out, const T& val) {
+    out.write((const char*)&val, sizeof(T));
+}
+
+template<typename T>
+static bool ReadVal(std::ifstream& in, T& val) {
+    return (bool)in.read((char*)&val, sizeof(T));
+}
+
+// Vec is padded, so only the components are written
+static void WriteVec(std::ofstream& out, const Vec& vec) {
+    WriteVal(out, vec.x);
+    WriteVal(out, vec.y);
+    WriteVal(out, vec.z);
+}
+
+static bool ReadVec(std::ifstream& in, Vec& vec) {
+    return ReadVal(in, vec.x) && ReadVal(in, vec.y) && ReadVal(in, vec.z);
+}
+
+static void WritePhys(std::ofstream& out, const PhysState& phys) {
+    WriteVec(out, phys.pos);
+    WriteVec(out, phys.rotMat.forward);
+    WriteVec(out, phys.rotMat.right);
+    WriteVec(out, phys.rotMat.up);
+    WriteVec(out, phys.vel);
+    WriteVec(out, phys.angVel);
+}
+
+static bool ReadPhys(std::ifstream& in, PhysState& phys) {
+    return ReadVec(in, phys.pos)
+        && ReadVec(in, phys.rotMat.forward) && ReadVec(in, phys.rotMat.right) && ReadVec(in, phys.rotMat.up)
+        && ReadVec(in, phys.vel) && ReadVec(in, phys.angVel);
+}
+
+static bool ReadPacket(std::ifstream& in, RLBotPacket& packet) {
+    if (!ReadVal(in, packet.frameNum) || !ReadVal(in, packet.secondsElapsed)
+        || !ReadVal(in, packet.isKickoffPause) || !ReadVal(in, packet.isRoundActive))
+        return false;
+
+    if (!ReadPhys(in, packet.ball))
+        return false;
+
+    if (!ReadVal(in, packet.hasLatestTouch) || !ReadVal(in, packet.latestTouch.playerIndex)
+        || !ReadVal(in, packet.latestTouch.gameSeconds) || !ReadVec(in, packet.latestTouch.location))
+        return false;
+
+    uint32_t padAmount;
+    if (!ReadVal(in, padAmount))
+        return false;
+    packet.boostPads.resize(padAmount);
+    for (auto& pad : packet.boostPads)
+        if (!ReadVal(in, pad.isActive) || !ReadVal(in, pad.timer))
+            return false;
+
+    uint32_t carAmount;
+    if (!ReadVal(in, carAmount))
+        return false;
+    packet.cars.resize(carAmount);
+    for (auto& car : packet.cars) {
+        if (!ReadPhys(in, car.phys) || !ReadVal(in, car.spawnId) || !ReadVal(in, car.team) || !ReadVal(in, car.boost)
+            || !ReadVal(in, car.isDemolished) || !ReadVal(in, car.hasWheelContact)
+            || !ReadVal(in, car.jumped) || !ReadVal(in, car.doubleJumped) || !ReadVal(in, car.isSupersonic))
+            return false;
+    }
+
+    return ReadVal(in, packet.teamScores[0]) && ReadVal(in, packet.teamScores[1]);
+}
+
+PacketRecorder::PacketRecorder(const std::filesystem::path& path, int botIndex, int botTeam) {
+    out.open(path, std::ios::binary);
+    if (!out.good()) {
+        RG_LOG("PacketRecorder: Failed to open " << path << ", packets will not be recorded");
+        return;
+    }
+
+    WriteVal(out, MAGIC);
+    WriteVal(out, VERSION);
+    WriteVal(out, (int32_t)botIndex);
+    WriteVal(out, (int32_t)botTeam);
+    RG_LOG("PacketRecorder: Recording packets to " << path);
+}
+
+void PacketRecorder::Write(const RLBotPacket& packet) {
+    if (!out.good())
+        return;
+
+    WriteVal(out, packet.frameNum);
+    WriteVal(out, packet.secondsElapsed);
+    WriteVal(out, packet.isKickoffPause);
+    WriteVal(out, packet.isRoundActive);
+
+    WritePhys(out, packet.ball);
+
+    WriteVal(out, packet.hasLatestTouch);
+    WriteVal(out, packet.latestTouch.playerIndex);
+    WriteVal(out, packet.latestTouch.gameSeconds);
+    WriteVec(out, packet.latestTouch.location);
+
+    WriteVal(out, (uint32_t)packet.boostPads.size());
+    for (auto& pad : packet.boostPads) {
+        WriteVal(out, pad.isActive);
+        WriteVal(out, pad.timer);
+    }
+
+    WriteVal(out, (uint32_t)packet.cars.size());
+    for (auto& car : packet.cars) {
+        WritePhys(out, car.phys);
+        WriteVal(out, car.spawnId);
+        WriteVal(out, car.team);
+        WriteVal(out, car.boost);
+        WriteVal(out, car.isDemolished);
+        WriteVal(out, car.hasWheelContact);
+        WriteVal(out, car.jumped);
+        WriteVal(out, car.doubleJumped);
+        WriteVal(out, car.isSupersonic);
+    }
+
+    WriteVal(out, packet.teamScores[0]);
+    WriteVal(out, packet.teamScores[1]);
+}
+
+bool PacketLog::Read(const std::filesystem::path& path, PacketLog& outLog) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.good()) {
+        RG_LOG("PacketLog: Failed to open " << path);
+        return false;
+    }
+
+    uint32_t magic, version;
+    int32_t botIndex, botTeam;
+    if (!ReadVal(in, magic) || !ReadVal(in, version) || !ReadVal(in, botIndex) || !ReadVal(in, botTeam)
+        || magic != PacketRecorder::MAGIC) {
+        RG_LOG("PacketLog: " << path << " is not a packet log");
+        return false;
+    }
+
+    if (version != PacketRecorder::VERSION) {
+        RG_LOG("PacketLog: " << path << " is version " << version << ", expected " << PacketRecorder::VERSION);
+        return false;
+    }
+
+    outLog.botIndex = botIndex;
+    outLog.botTeam = botTeam;
+    outLog.packets.clear();
+
+    RLBotPacket packet;
+    while (ReadPacket(in, packet))
+        outLog.packets.push_back(packet);
+
+    if (!in.eof())
+        RG_LOG("PacketLog: Stopped reading " << path << " after " << outLog.packets.size() << " packets");
+
+    return true;
+}
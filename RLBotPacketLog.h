@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+
+struct RLBotPacket;
+
+// Binary log of the packets one bot received, so a match can be replayed through the bot later (see RLBotGoldenTrace.h)
+// Layout: a header (magic, version, bot index, team), then every packet's fields back to back
+class PacketRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x4B504C47; // "GLPK"
+    static constexpr uint32_t VERSION = 1;
+
+    PacketRecorder(const std::filesystem::path& path, int botIndex, int botTeam);
+
+    bool IsOpen() const { return out.good(); }
+
+    // Buffered, only flushed by the stream when its buffer fills up
+    void Write(const RLBotPacket& packet);
+
+private:
+    std::ofstream out;
+};
+
+struct PacketLog {
+    int botIndex = 0;
+    int botTeam = 0;
+    std::vector<RLBotPacket> packets;
+
+    // Returns false if the file can't be read or isn't a packet log of this version
+    // A log cut off mid-packet (bot killed while recording) still loads every complete packet
+    static bool Read(const std::filesystem::path& path, PacketLog& outLog);
+};
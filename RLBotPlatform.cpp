@@ -0,0 +1,187 @@
+#include "RLBotPlatform.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <cerrno>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace fs = std::filesystem;
+
+uint32_t RLBotPlatform::GetPID() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+}
+
+bool RLBotPlatform::IsProcessAlive(uint32_t pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process)
+        return false;
+    DWORD exitCode = 0;
+    bool alive = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
+static std::vector<fs::path> ListCheckpointFiles(const fs::path& checkpointPath) {
+    std::vector<fs::path> result;
+    if (!fs::is_directory(checkpointPath)) {
+        result.push_back(checkpointPath);
+        return result;
+    }
+
+    for (auto& entry : fs::directory_iterator(checkpointPath)) {
+        if (!entry.is_regular_file())
+            continue;
+        std::string fileName = entry.path().filename().string();
+        if (fileName.find("CRITIC") != std::string::npos || fileName.find("OPTIM") != std::string::npos)
+            continue;
+        result.push_back(entry.path());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+uint64_t RLBotPlatform::HashCheckpoint(const fs::path& checkpointPath) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto hashBytes = [&](const void* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= ((const uint8_t*)data)[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+
+    std::error_code ec;
+    std::string canonicalPath = fs::weakly_canonical(checkpointPath, ec).string();
+    hashBytes(canonicalPath.data(), canonicalPath.size());
+
+    for (auto& file : ListCheckpointFiles(checkpointPath)) {
+        std::string fileName = file.filename().string();
+        uint64_t fileSize = fs::file_size(file, ec);
+        int64_t writeTime = fs::last_write_time(file, ec).time_since_epoch().count();
+        hashBytes(fileName.data(), fileName.size());
+        hashBytes(&fileSize, sizeof(fileSize));
+        hashBytes(&writeTime, sizeof(writeTime));
+    }
+
+    return hash;
+}
+
+bool RLBotPlatform::SetCurrentThreadLowPriority() {
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+#elif defined(__linux__)
+    // Linux applies nice values per thread
+    return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19) == 0;
+#else
+    return false;
+#endif
+}
+
+bool RLBotPlatform::CreateMappedFile(const std::filesystem::path& path, size_t size, MappedFile& outFile) {
+    outFile = {};
+#ifdef _WIN32
+    // Shared so offline tools can read the file while it's being written
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    // Mapping past the end of the file extends it
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    outFile.fileHandle = file;
+    outFile.mappingHandle = mapping;
+#else
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return false;
+
+#ifdef __linux__
+    bool allocated = posix_fallocate(fd, 0, (off_t)size) == 0;
+#else
+    bool allocated = ftruncate(fd, (off_t)size) == 0;
+#endif
+    if (!allocated) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    outFile.fd = fd;
+#endif
+    outFile.data = data;
+    outFile.size = size;
+    return true;
+}
+
+bool RLBotPlatform::FlushMappedFile(const MappedFile& file, size_t offset, size_t length) {
+    if (!file.data || length == 0)
+        return true;
+#ifdef _WIN32
+    return FlushViewOfFile((uint8_t*)file.data + offset, length);
+#else
+    // msync() needs a page-aligned start
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t alignedOffset = offset - (offset % pageSize);
+    return msync((uint8_t*)file.data + alignedOffset, length + (offset - alignedOffset), MS_SYNC) == 0;
+#endif
+}
+
+void RLBotPlatform::CloseMappedFile(MappedFile& file, size_t newSize) {
+    if (!file.data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(file.data);
+    CloseHandle(file.mappingHandle);
+    LARGE_INTEGER newEnd;
+    newEnd.QuadPart = (LONGLONG)newSize;
+    if (SetFilePointerEx(file.fileHandle, newEnd, NULL, FILE_BEGIN))
+        SetEndOfFile(file.fileHandle);
+    CloseHandle(file.fileHandle);
+#else
+    munmap(file.data, file.size);
+    // If this fails the file just keeps its preallocated size, the header still says how many rows are valid
+    if (ftruncate(file.fd, (off_t)newSize) != 0) {}
+    close(file.fd);
+#endif
+    file = {};
+}
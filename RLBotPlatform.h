@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+// Small OS and filesystem helpers shared by the host-level (multi-process) features
+namespace RLBotPlatform {
+    uint32_t GetPID();
+
+    // PIDs can be reused, so this is only a best-effort check for stale entries left by crashed processes
+    bool IsProcessAlive(uint32_t pid);
+
+    // Hash of a checkpoint's path, file names, sizes and write times, for keying anything cached per checkpoint
+    uint64_t HashCheckpoint(const std::filesystem::path& checkpointPath);
+
+    // Lowest scheduling priority for the calling thread, so it only runs on otherwise idle time
+    bool SetCurrentThreadLowPriority();
+
+    // Read-write shared mapping of a whole file
+    struct MappedFile {
+        void* data = nullptr;
+        size_t size = 0;
+        void* fileHandle = nullptr; // Windows
+        void* mappingHandle = nullptr; // Windows
+        int fd = -1; // Everywhere else
+    };
+
+    // Creates (or overwrites) the file at the given size and maps it
+    // Its disk space is allocated up front where the OS supports it, so writes through the mapping can't run out of it
+    bool CreateMappedFile(const std::filesystem::path& path, size_t size, MappedFile& outFile);
+
+    // Blocks until that range of the mapping is written back to the file
+    bool FlushMappedFile(const MappedFile& file, size_t offset, size_t length);
+
+    // Unmaps and closes the file, first cutting it down to newSize bytes
+    void CloseMappedFile(MappedFile& file, size_t newSize);
+}
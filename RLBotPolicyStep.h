@@ -0,0 +1,24 @@
+#pragma once
+
+#include <RLGymCPP/Framework.h>
+#include <RLGymCPP/Gamestates/GameState.h>
+#include <memory>
+
+// One policy step, copied off the tick thread for a background thread to work on (shadow evaluation, capture)
+struct PolicyStep {
+    int frameNum;
+    int playerIndex;
+    RLGC::GameState state;
+    RLGC::Action action;
+    float inferMs; // Time the policy took to pick the action, 0 if not measured
+
+    static std::unique_ptr<PolicyStep> Copy(int frameNum, int playerIndex, const RLGC::GameState& state,
+        const RLGC::Action& action, float inferMs = 0) {
+        auto step = std::make_unique<PolicyStep>(PolicyStep{ frameNum, playerIndex, state, action, inferMs });
+
+        // These point into the bot's previous state, which the tick thread keeps overwriting
+        for (auto& player : step->state.players)
+            player.prev = nullptr;
+        return step;
+    }
+};
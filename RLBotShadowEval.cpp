@@ -0,0 +1,147 @@
+#include "RLBotShadowEval.h"
+#include "RLBotAffinity.h"
+#include "RLBotPlatform.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace RLGC;
+
+static void WriteAction(std::ofstream& out, const Action& action) {
+    out << action.throttle << "," << action.steer << "," << action.pitch << "," << action.yaw << ","
+        << action.roll << "," << action.jump << "," << action.boost << "," << action.handbrake;
+}
+
+static bool ActionsMatch(const Action& a, const Action& b) {
+    return a.throttle == b.throttle && a.steer == b.steer && a.pitch == b.pitch && a.yaw == b.yaw
+        && a.roll == b.roll && a.jump == b.jump && a.boost == b.boost && a.handbrake == b.handbrake;
+}
+
+static float GetP99(std::vector<float>& samples) {
+    auto itr = samples.begin() + (samples.size() * 99 / 100);
+    std::nth_element(samples.begin(), itr, samples.end());
+    return *itr;
+}
+
+ShadowEvaluator::ShadowEvaluator(GGL::InferUnit* candidate, bool deterministic, float cpuBudget, const std::vector<int>& cores,
+    int botIndex, const std::filesystem::path& logPath)
+    : candidate(candidate), deterministic(deterministic), botIndex(botIndex), cores(cores), cpuBudget(cpuBudget) {
+
+    log.open(logPath);
+    if (!log.good())
+        RG_LOG("ShadowEvaluator: Failed to open " << logPath << ", candidate actions will not be logged");
+
+    const char* actionColumns[] = { "throttle", "steer", "pitch", "yaw", "roll", "jump", "boost", "handbrake" };
+    log << "frame,player";
+    for (const char* prefix : { "primary_", "candidate_" }) {
+        for (const char* column : actionColumns)
+            log << "," << prefix << column;
+        log << "," << prefix << "ms";
+    }
+    log << ",match" << std::endl;
+
+    RG_LOG("ShadowEvaluator: Shadowing bot " << botIndex << " with a CPU budget of " << (int)(cpuBudget * 100) << "%, logging to " << logPath);
+    thread = std::thread(&ShadowEvaluator::ThreadLoop, this);
+}
+
+ShadowEvaluator::~ShadowEvaluator() {
+    mailbox.Interrupt();
+    if (thread.joinable())
+        thread.join();
+
+    RG_LOG("ShadowEvaluator: Bot " << botIndex << " submitted " << submittedSteps << " step(s), "
+        << skippedSteps << " skipped because the candidate was behind");
+}
+
+void ShadowEvaluator::Submit(int frameNum, int playerIndex, const GameState& state,
+    const Action& primaryAction, float primaryInferMs) {
+    if (!IsEnabled())
+        return;
+
+    submittedSteps++;
+    if (mailbox.Publish(PolicyStep::Copy(frameNum, playerIndex, state, primaryAction, primaryInferMs)))
+        skippedSteps++;
+}
+
+void ShadowEvaluator::BeginPrimaryInference() {
+    activityAtInferenceStart = candidateActivity.load(std::memory_order_acquire);
+}
+
+void ShadowEvaluator::EndPrimaryInference(float inferMs) {
+    if (!IsEnabled())
+        return;
+
+    // The candidate ran at some point during this inference if it was running at the start or has started/stopped since
+    uint64_t activity = candidateActivity.load(std::memory_order_acquire);
+    bool overlapped = (activityAtInferenceStart % 2 == 1) || (activity != activityAtInferenceStart);
+    (overlapped ? inferMsBusy : inferMsIdle).push_back(inferMs);
+
+    if (inferMsBusy.size() >= MIN_LATENCY_SAMPLES && inferMsIdle.size() >= MIN_LATENCY_SAMPLES) {
+        CheckPrimaryLatency();
+    } else if (inferMsBusy.size() + inferMsIdle.size() > MIN_LATENCY_SAMPLES * 100) {
+        // Almost never one of the two, nothing to compare against
+        inferMsBusy.clear();
+        inferMsIdle.clear();
+    }
+}
+
+void ShadowEvaluator::CheckPrimaryLatency() {
+    float idleP99 = GetP99(inferMsIdle);
+    float busyP99 = GetP99(inferMsBusy);
+    inferMsIdle.clear();
+    inferMsBusy.clear();
+
+    // Leave some room for timer noise
+    float allowedP99 = idleP99 + RS_MAX(idleP99 * 0.1f, 0.25f);
+
+    RG_LOG("ShadowEvaluator: Bot " << botIndex << " primary inference p99 is " << idleP99 << "ms alone, "
+        << busyP99 << "ms alongside the candidate (allowed: " << allowedP99 << "ms), "
+        << skippedSteps << "/" << submittedSteps << " steps skipped");
+
+    if (busyP99 <= allowedP99) {
+        failedChecks = 0;
+        return;
+    }
+
+    failedChecks++;
+    if (failedChecks >= 3) {
+        enabled = false;
+        RG_LOG("ShadowEvaluator: Candidate keeps slowing down the primary, shadowing disabled for bot " << botIndex);
+    } else {
+        float newBudget = cpuBudget.load() / 2;
+        cpuBudget = newBudget;
+        RG_LOG("ShadowEvaluator: Candidate is slowing down the primary, CPU budget lowered to " << (newBudget * 100) << "%");
+    }
+}
+
+void ShadowEvaluator::ThreadLoop() {
+    if (!RLBotPlatform::SetCurrentThreadLowPriority())
+        RG_LOG("ShadowEvaluator: Failed to lower shadow thread priority");
+    RLBotAffinity::ApplyBackgroundThreadSettings(cores);
+
+    while (auto step = mailbox.WaitTake()) {
+        if (!IsEnabled())
+            continue;
+
+        const Player& player = step->state.players[step->playerIndex];
+
+        candidateActivity.fetch_add(1, std::memory_order_acq_rel);
+        auto startTime = std::chrono::steady_clock::now();
+        Action candidateAction = candidate->InferAction(player, step->state, deterministic);
+        float inferMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        candidateActivity.fetch_add(1, std::memory_order_acq_rel);
+
+        log << step->frameNum << "," << step->playerIndex << ",";
+        WriteAction(log, step->action);
+        log << "," << step->inferMs << ",";
+        WriteAction(log, candidateAction);
+        log << "," << inferMs << "," << ActionsMatch(step->action, candidateAction) << "\n";
+
+        // Idle in proportion to the time that step took, so the candidate only runs cpuBudget of the time
+        // Its inference is single-threaded, so that caps it at cpuBudget of one core
+        // Steps that arrive in the meantime overwrite each other in the mailbox, so only the newest one runs next
+        float budget = RS_CLAMP(cpuBudget.load(), 0.01f, 1.f);
+        std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(inferMs * (1 / budget - 1)));
+    }
+
+    log.flush();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "RLBotMailbox.h"
+#include "RLBotPolicyStep.h"
+#include <GigaLearnCPP/Util/InferUnit.h>
+#include <RLGymCPP/Framework.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Runs a candidate checkpoint on the same states as the primary policy, without it ever controlling the car
+// The candidate runs on its own low-priority thread, and steps it can't keep up with are skipped
+// Its CPU inference is single-threaded on that thread and kept off the tick thread's core (see ApplyBackgroundThreadSettings()),
+//  and the thread idles in proportion to each step's inference time, so it uses at most cpuBudget of one core
+// Both policies' actions and latencies are logged side by side, and the primary's inference latency is
+//  compared between inferences the candidate overlapped and ones it didn't: if the candidate measurably slows
+//  the primary down, the budget is halved, and shadowing stops if that keeps happening
+class ShadowEvaluator {
+public:
+    // Minimum amount of primary inferences of each kind before latencies are compared
+    static constexpr int MIN_LATENCY_SAMPLES = 500;
+
+    GGL::InferUnit* candidate;
+    bool deterministic;
+    int botIndex;
+
+    // cores are the ones leased to this process (RLBotParams::cores), may be empty
+    ShadowEvaluator(GGL::InferUnit* candidate, bool deterministic, float cpuBudget, const std::vector<int>& cores,
+        int botIndex, const std::filesystem::path& logPath);
+    ~ShadowEvaluator();
+
+    // Called on the tick thread after the primary acted, only copies the state and never blocks
+    void Submit(int frameNum, int playerIndex, const RLGC::GameState& state,
+        const RLGC::Action& primaryAction, float primaryInferMs);
+
+    // Called on the tick thread around every primary policy inference (cache hits don't count)
+    void BeginPrimaryInference();
+    void EndPrimaryInference(float inferMs);
+
+    bool IsEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<int> cores;
+    LatestMailbox<PolicyStep> mailbox;
+    std::thread thread;
+    std::ofstream log;
+
+    std::atomic<float> cpuBudget;
+    std::atomic<bool> enabled = true;
+
+    // Incremented when candidate inference starts and ends, so it is odd while the candidate is running
+    std::atomic<uint64_t> candidateActivity = 0;
+
+    // Tick thread only
+    uint64_t activityAtInferenceStart = 0;
+    uint64_t submittedSteps = 0, skippedSteps = 0;
+    std::vector<float> inferMsIdle, inferMsBusy;
+    int failedChecks = 0;
+
+    void ThreadLoop();
+    void CheckPrimaryLatency();
+};
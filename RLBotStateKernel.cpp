@@ -0,0 +1,297 @@
+#include "RLBotStateKernel.h"
+#include "RLBotClient.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+using namespace RLGC;
+
+Vec CalcFlipRelTorque(float pitch, float yaw) {
+    // Normalize the dodge direction
+    Vec dodgeDir = Vec(pitch, yaw, 0);
+    float dodgeMag = dodgeDir.Length();
+
+    if (dodgeMag > 0.1f) {
+        dodgeDir = dodgeDir.Normalized();
+
+        // Apply deadzones (< 0.1 becomes 0)
+        if (std::abs(dodgeDir.x) < 0.1f) dodgeDir.x = 0;
+        if (std::abs(dodgeDir.y) < 0.1f) dodgeDir.y = 0;
+
+        // Calculate relative flip torque: flipRelTorque = (-yaw, pitch, 0)
+        // This matches RocketSim's calculation
+        return Vec(-dodgeDir.y, dodgeDir.x, 0);
+    } else {
+        // Neutral flip (straight up double jump) - no flip torque
+        return Vec(0, 0, 0);
+    }
+}
+
+// Branchless a-or-b, cond must be 0 or 1
+static inline float Select(uint32_t cond, float a, float b) {
+    uint32_t mask = 0u - cond;
+    return std::bit_cast<float>((std::bit_cast<uint32_t>(a) & mask) | (std::bit_cast<uint32_t>(b) & ~mask));
+}
+
+static inline uint32_t Select(uint32_t cond, uint32_t a, uint32_t b) {
+    uint32_t mask = 0u - cond;
+    return (a & mask) | (b & ~mask);
+}
+
+PlayerStateKernel::PlayerStateKernel() {
+    // Lanes that never held a car keep the inputs of a car on the ground with no previous state
+    // That keeps their zeroed state zeroed, so a car that shows up there later starts fresh like a new internalPlayerStates entry
+    std::fill(std::begin(inOnGround), std::end(inOnGround), 1u);
+}
+
+void PlayerStateKernel::CopyLanes(State& to, const State& from, int begin, int end) {
+    constexpr size_t FIELD_SIZE = sizeof(uint32_t) * MAX_CARS;
+    static_assert(sizeof(State) % FIELD_SIZE == 0, "State fields must all be 4-byte lanes");
+
+    for (size_t offset = 0; offset < sizeof(State); offset += FIELD_SIZE)
+        memcpy((char*)&to + offset + begin * sizeof(uint32_t), (const char*)&from + offset + begin * sizeof(uint32_t),
+            (end - begin) * sizeof(uint32_t));
+}
+
+void PlayerStateKernel::Step(std::vector<Player>& players, const std::vector<Player*>& prevPlayers,
+    float deltaTime, uint64_t tickCount, int localIndex, const Action& localControls) {
+    using namespace RLBotConst;
+
+    int carAmount = (int)players.size();
+    if (carAmount > MAX_CARS)
+        RG_ERR_CLOSE("PlayerStateKernel: Too many cars (" << carAmount << "), max is " << MAX_CARS);
+    int blockEnd = (carAmount + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    const float dt = deltaTime;
+
+    // Gather
+    for (int i = 0; i < carAmount; i++) {
+        // No && or || here either, these inputs change often enough that branching on them mispredicts
+        const Player& player = players[i];
+        const Player* prevPlayer = prevPlayers[i];
+        const uint32_t hasPrev = prevPlayer != nullptr;
+        const Player& prevOrCurrent = hasPrev ? *prevPlayer : player;
+        const uint32_t isLocalPlayer = i == localIndex;
+
+        inSupersonic[i] = player.isSupersonic;
+        inBoosting[i] = (isLocalPlayer & (localControls.boost != 0)) | (hasPrev & (prevOrCurrent.prevAction.boost != 0));
+        inHandbraking[i] = (isLocalPlayer & (localControls.handbrake != 0)) | (hasPrev & (prevOrCurrent.prevAction.handbrake != 0));
+        inOnGround[i] = player.isOnGround;
+        inDemoed[i] = player.isDemoed;
+        inJumped[i] = player.hasJumped;
+        inDoubleJumped[i] = player.hasDoubleJumped;
+        inHasPrev[i] = hasPrev;
+        inPrevJumped[i] = hasPrev & prevOrCurrent.hasJumped;
+        inPrevDoubleJumped[i] = hasPrev & prevOrCurrent.hasDoubleJumped;
+        inShouldAutoFlip[i] = (player.rotMat.up.z < CAR_AUTOFLIP_NORMZ_THRESH) & (std::abs(player.rotMat.forward.z) < 0.9f);
+    }
+
+    // Lanes that held a car are parked around the main loop, see usedLanes
+    int parkEnd = RS_MIN(usedLanes, blockEnd);
+    if (parkEnd > carAmount)
+        CopyLanes(parked, state, carAmount, parkEnd);
+    usedLanes = RS_MAX(usedLanes, carAmount);
+
+    // Advance every car
+    // The loop is straight-line code (flags are 0/1 lanes combined with & and |, and every choice is a Select()), so it vectorizes
+    // Comparisons are written the same way as in UpdatePlayerState() (e.g. !(a < b) rather than a >= b) so NaNs behave the same
+    State& st = state;
+    for (int blockStart = 0; blockStart < blockEnd; blockStart += BLOCK_SIZE) {
+        for (int j = 0; j < BLOCK_SIZE; j++) {
+            const int i = blockStart + j;
+            const uint32_t onGround = inOnGround[i], inAir = onGround ^ 1;
+            const uint32_t hasJumped = inJumped[i], hasDoubleJumped = inDoubleJumped[i];
+            const uint32_t hasPrev = inHasPrev[i], prevJumped = inPrevJumped[i], prevDoubleJumped = inPrevDoubleJumped[i];
+            const uint32_t boosting = inBoosting[i], demoed = inDemoed[i], shouldAutoFlip = inShouldAutoFlip[i];
+
+            // Supersonic
+            float supersonicAdvanced = st.supersonicTime[i] + dt;
+            supersonicAdvanced = Select(supersonicAdvanced > SUPERSONIC_MAINTAIN_MAX_TIME, SUPERSONIC_MAINTAIN_MAX_TIME, supersonicAdvanced);
+            st.supersonicTime[i] = Select(inSupersonic[i], supersonicAdvanced, 0.f);
+
+            // Boost
+            float boostTime = st.timeSpentBoosting[i];
+            uint32_t boostStarted = boostTime > 0;
+            uint32_t boostStops = (boosting ^ 1) & (boostTime >= BOOST_MIN_TIME);
+            float boostTimeNew = Select(boostStarted, boostTime + dt, boostTime);
+            boostTimeNew = Select(boostStarted & boostStops, 0.f, boostTimeNew);
+            st.timeSpentBoosting[i] = Select((boostStarted ^ 1) & boosting, dt, boostTimeNew);
+
+            // Handbrake
+            float handbrake = Select(inHandbraking[i],
+                st.handbrakeVal[i] + POWERSLIDE_RISE_RATE * dt,
+                st.handbrakeVal[i] - POWERSLIDE_FALL_RATE * dt);
+            handbrake = Select(handbrake < 0.f, 0.f, Select(handbrake > 1.f, 1.f, handbrake));
+            st.handbrakeVal[i] = handbrake;
+
+            // Demo
+            uint32_t wasDemoed = st.wasDemoedLastFrame[i];
+            float demoTimer = st.demoRespawnTimer[i];
+            float demoCountdown = demoTimer - dt;
+            demoCountdown = Select(demoCountdown < 0, 0.f, demoCountdown);
+            demoTimer = Select(demoed & wasDemoed, demoCountdown, demoTimer);
+            demoTimer = Select(demoed & (wasDemoed ^ 1), DEMO_RESPAWN_TIME, demoTimer);
+            st.demoRespawnTimer[i] = Select((demoed ^ 1) & wasDemoed, 0.f, demoTimer);
+            st.wasDemoedLastFrame[i] = demoed;
+
+            // Car contact cooldown
+            float cooldown = st.carContactCooldown[i];
+            float cooldownAdvanced = cooldown - dt;
+            uint32_t cooldownActive = cooldown > 0;
+            uint32_t cooldownEnds = cooldownActive & (cooldownAdvanced < 0);
+            st.carContactCooldown[i] = Select(cooldownEnds, 0.f, Select(cooldownActive, cooldownAdvanced, cooldown));
+            st.carContactOtherID[i] = Select(cooldownEnds, 0u, st.carContactOtherID[i]);
+
+            // Air branch of UpdatePlayerState(), computed for every car and only kept for cars in the air
+            uint32_t isJumping = st.isJumping[i];
+            float jumpTime = st.jumpTime[i];
+            float jumpTimeAdvanced = jumpTime + dt;
+            float jumpTimeAir = Select(isJumping, jumpTimeAdvanced, jumpTime);
+            uint32_t isJumpingAir = isJumping & !(jumpTimeAdvanced >= JUMP_MAX_TIME);
+
+            uint32_t isFlipping = st.isFlipping[i];
+            float flipTime = st.flipTime[i];
+            float flipTimeAdvanced = flipTime + dt;
+            float flipTimeAir = Select(isFlipping, flipTimeAdvanced, flipTime);
+            uint32_t isFlippingAir = isFlipping & !(flipTimeAdvanced >= FLIP_TORQUE_TIME);
+
+            float airTimeAir = st.airTime[i] + dt;
+            float airTimeSinceJumpAir = Select(hasJumped & (isJumpingAir ^ 1), st.airTimeSinceJump[i] + dt, 0.f);
+
+            uint32_t isAutoFlipping = st.isAutoFlipping[i];
+            float autoFlipTimerAdvanced = st.autoFlipTimer[i] + dt;
+            uint32_t autoFlipStarts = shouldAutoFlip & (autoFlipTimerAdvanced >= CAR_AUTOFLIP_TIME) & (isAutoFlipping ^ 1);
+            uint32_t autoFlipClears = onGround | (shouldAutoFlip ^ 1);
+
+            // Flip reset detection
+            uint32_t flipReset = hasPrev & st.hadJumpedLastFrame[i] & (hasJumped ^ 1);
+            uint32_t doubleJumpReset = hasPrev & st.hadDoubleJumpedLastFrame[i] & (hasDoubleJumped ^ 1) & hasJumped;
+            uint32_t anyReset = flipReset | doubleJumpReset;
+
+            // The player only gets the air timers while in the air, and gets them from before a flip reset clears them
+            outAirTime[i] = airTimeAir;
+            outJumpTime[i] = jumpTimeAir;
+            outFlipTime[i] = flipTimeAir;
+            outAirTimeSinceJump[i] = airTimeSinceJumpAir;
+
+            // Merge the ground and air branches
+            uint32_t clearsFlip = onGround | flipReset;
+            uint32_t jumpTimeResets = onGround & hasPrev & prevJumped & !(jumpTime < JUMP_MIN_TIME + JUMP_RESET_TIME_PAD);
+            st.airTime[i] = Select(onGround, 0.f, airTimeAir);
+            st.airTimeSinceJump[i] = Select(clearsFlip, 0.f, airTimeSinceJumpAir);
+            st.autoFlipTimer[i] = Select(autoFlipClears, 0.f, autoFlipTimerAdvanced);
+            st.isAutoFlipping[i] = inAir & shouldAutoFlip & (isAutoFlipping | autoFlipStarts);
+            st.autoFlipTorqueScale[i] = Select(autoFlipClears, 0.f, st.autoFlipTorqueScale[i]);
+            st.gotFlipResetThisFrame[i] = Select(onGround, st.gotFlipResetThisFrame[i], anyReset);
+            st.flipTorqueX[i] = Select(clearsFlip, 0.f, st.flipTorqueX[i]);
+            st.flipTorqueY[i] = Select(clearsFlip, 0.f, st.flipTorqueY[i]);
+            st.flipTorqueZ[i] = Select(clearsFlip, 0.f, st.flipTorqueZ[i]);
+
+            // Jump and flip starts
+            uint32_t jumpStarts = hasPrev & hasJumped & (prevJumped ^ 1);
+            uint32_t flipStarts = hasPrev & hasDoubleJumped & (prevDoubleJumped ^ 1) & inAir;
+            st.isJumping[i] = ((inAir & isJumpingAir) | jumpStarts) & (flipStarts ^ 1);
+            st.isFlipping[i] = ((clearsFlip ^ 1) & isFlippingAir & (jumpStarts ^ 1)) | flipStarts;
+            st.hasFlipped[i] = ((clearsFlip ^ 1) & st.hasFlipped[i]) | flipStarts;
+            jumpTime = Select(jumpTimeResets, 0.f, jumpTime);
+            st.jumpTime[i] = Select(jumpStarts, 0.f, Select(inAir, jumpTimeAir, jumpTime));
+            st.flipTime[i] = Select(clearsFlip | jumpStarts | flipStarts, 0.f, flipTimeAir);
+
+            st.hadJumpedLastFrame[i] = hasJumped;
+            st.hadDoubleJumpedLastFrame[i] = hasDoubleJumped;
+
+            // Masks for the rare pass
+            outDemoStarts[i] = demoed & (wasDemoed ^ 1);
+            outFlipReset[i] = inAir & anyReset;
+            outAutoFlipStarts[i] = inAir & autoFlipStarts;
+            outFlipStarts[i] = flipStarts;
+        }
+    }
+
+    if (parkEnd > carAmount)
+        CopyLanes(state, parked, carAmount, parkEnd);
+
+    // Rare pass and scatter
+    for (int i = 0; i < carAmount; i++) {
+        Player& player = players[i];
+
+        if (outDemoStarts[i])
+            demoTick[i] = tickCount;
+        if (outFlipReset[i])
+            lastFlipResetTick[i] = tickCount;
+        if (outAutoFlipStarts[i]) {
+            // Calculate auto-flip direction based on roll angle
+            Angle angles = Angle::FromRotMat(player.rotMat);
+            if (std::abs(angles.roll) > CAR_AUTOFLIP_ROLL_THRESH)
+                st.autoFlipTorqueScale[i] = (angles.roll > 0) ? 1.f : -1.f;
+        }
+        if (outFlipStarts[i]) {
+            Action currentAction = (i == localIndex) ? localControls : prevPlayers[i]->prevAction;
+            Vec torque = CalcFlipRelTorque(currentAction.pitch, currentAction.yaw);
+            st.flipTorqueX[i] = torque.x;
+            st.flipTorqueY[i] = torque.y;
+            st.flipTorqueZ[i] = torque.z;
+        }
+
+        player.airTime = Select(inOnGround[i], player.airTime, outAirTime[i]);
+        player.jumpTime = Select(inOnGround[i], player.jumpTime, outJumpTime[i]);
+        player.flipTime = Select(inOnGround[i], player.flipTime, outFlipTime[i]);
+        player.airTimeSinceJump = Select(inOnGround[i], player.airTimeSinceJump, outAirTimeSinceJump[i]);
+
+        player.supersonicTime = st.supersonicTime[i];
+        player.timeSpentBoosting = st.timeSpentBoosting[i];
+        player.handbrakeVal = st.handbrakeVal[i];
+        for (int j = 0; j < 4; j++)
+            player.wheelsWithContact[j] = inOnGround[i];
+        player.demoRespawnTimer = st.demoRespawnTimer[i];
+        player.carContact.otherCarID = st.carContactOtherID[i];
+        player.carContact.cooldownTimer = st.carContactCooldown[i];
+        player.isJumping = st.isJumping[i];
+        player.isFlipping = st.isFlipping[i];
+        player.hasFlipped = st.hasFlipped[i];
+        player.flipRelTorque = Vec(st.flipTorqueX[i], st.flipTorqueY[i], st.flipTorqueZ[i]);
+        player.isAutoFlipping = st.isAutoFlipping[i];
+        player.autoFlipTimer = st.autoFlipTimer[i];
+        player.autoFlipTorqueScale = st.autoFlipTorqueScale[i];
+
+        // World contact isn't tracked (RLBot doesn't provide it), so it always has the defaults
+        player.worldContact.hasContact = false;
+        player.worldContact.contactNormal = Vec(0, 0, 1);
+    }
+}
+
+template <typename T>
+static bool BitsEqual(const T& a, const T& b) {
+    return memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+const char* FindTrackedStateMismatch(const Player& a, const Player& b) {
+#define CHECK_FIELD(field) if (!BitsEqual(a.field, b.field)) return #field
+    CHECK_FIELD(supersonicTime);
+    CHECK_FIELD(timeSpentBoosting);
+    CHECK_FIELD(handbrakeVal);
+    for (int i = 0; i < 4; i++)
+        CHECK_FIELD(wheelsWithContact[i]);
+    CHECK_FIELD(demoRespawnTimer);
+    CHECK_FIELD(carContact.otherCarID);
+    CHECK_FIELD(carContact.cooldownTimer);
+    CHECK_FIELD(airTime);
+    CHECK_FIELD(jumpTime);
+    CHECK_FIELD(flipTime);
+    CHECK_FIELD(airTimeSinceJump);
+    CHECK_FIELD(isJumping);
+    CHECK_FIELD(isFlipping);
+    CHECK_FIELD(hasFlipped);
+    CHECK_FIELD(flipRelTorque.x);
+    CHECK_FIELD(flipRelTorque.y);
+    CHECK_FIELD(flipRelTorque.z);
+    CHECK_FIELD(isAutoFlipping);
+    CHECK_FIELD(autoFlipTimer);
+    CHECK_FIELD(autoFlipTorqueScale);
+    CHECK_FIELD(worldContact.hasContact);
+    CHECK_FIELD(worldContact.contactNormal.x);
+    CHECK_FIELD(worldContact.contactNormal.y);
+    CHECK_FIELD(worldContact.contactNormal.z);
+#undef CHECK_FIELD
+    return nullptr;
+}
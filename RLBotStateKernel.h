@@ -0,0 +1,73 @@
+#pragma once
+
+#include <RLGymCPP/Framework.h>
+#include <RLGymCPP/Gamestates/GameState.h>
+#include <vector>
+#include <cstdint>
+
+// Relative flip torque for a dodge with the given stick input, same as RocketSim
+Vec CalcFlipRelTorque(float pitch, float yaw);
+
+// Branch-light version of RLBotBot::UpdatePlayerState() that advances every car in one pass
+// Tracked state lives here in fixed-size arrays (one per field) across packets, only the per-packet inputs are gathered
+//  and only the fields the Player exposes are written back
+// The main loop advances blocks of BLOCK_SIZE cars with selects only and a fixed trip count, so the compiler can vectorize it
+// The two expensive, rare cases (auto-flip roll and dodge direction) are flagged in mask arrays and handled afterwards
+// Results are bit-identical to UpdatePlayerState() as long as FP contraction is off (see CMakeLists.txt),
+//  otherwise the compiler may fuse a multiply-add in one and not the other. See RLBotParams::verifyStateKernel
+class PlayerStateKernel {
+public:
+    static constexpr int BLOCK_SIZE = 4; // One SSE vector of lanes
+    static constexpr int MAX_CARS = 64; // RLBot's player limit
+
+    PlayerStateKernel();
+
+    // prevPlayers[i] is the same car in the previous state, or nullptr
+    void Step(std::vector<RLGC::Player>& players, const std::vector<RLGC::Player*>& prevPlayers,
+        float deltaTime, uint64_t tickCount, int localIndex, const RLGC::Action& localControls);
+
+private:
+    // Tracked state, indexed like GameState::players
+    // Every field is one 4-byte lane per car (flags are 32-bit so they share lanes with the floats), see CopyLanes()
+    struct State {
+        float
+            supersonicTime[MAX_CARS], timeSpentBoosting[MAX_CARS], handbrakeVal[MAX_CARS],
+            demoRespawnTimer[MAX_CARS], carContactCooldown[MAX_CARS],
+            jumpTime[MAX_CARS], flipTime[MAX_CARS], airTime[MAX_CARS], airTimeSinceJump[MAX_CARS],
+            autoFlipTimer[MAX_CARS], autoFlipTorqueScale[MAX_CARS],
+            flipTorqueX[MAX_CARS], flipTorqueY[MAX_CARS], flipTorqueZ[MAX_CARS];
+        uint32_t
+            isJumping[MAX_CARS], isFlipping[MAX_CARS], hasFlipped[MAX_CARS], isAutoFlipping[MAX_CARS],
+            wasDemoedLastFrame[MAX_CARS], gotFlipResetThisFrame[MAX_CARS],
+            hadJumpedLastFrame[MAX_CARS], hadDoubleJumpedLastFrame[MAX_CARS],
+            carContactOtherID[MAX_CARS];
+    };
+    alignas(32) State state = {};
+
+    // Like RLBotBot::internalPlayerStates, state for an index is kept even if that car goes away
+    // The main loop still advances the unused lanes of the last block, so any that held a car are parked here around it
+    State parked;
+    int usedLanes = 0;
+
+    uint64_t demoTick[MAX_CARS] = {}, lastFlipResetTick[MAX_CARS] = {};
+
+    // Per-packet inputs
+    alignas(32) uint32_t
+        inSupersonic[MAX_CARS] = {}, inBoosting[MAX_CARS] = {}, inHandbraking[MAX_CARS] = {},
+        inOnGround[MAX_CARS] = {}, inDemoed[MAX_CARS] = {}, inJumped[MAX_CARS] = {}, inDoubleJumped[MAX_CARS] = {},
+        inHasPrev[MAX_CARS] = {}, inPrevJumped[MAX_CARS] = {}, inPrevDoubleJumped[MAX_CARS] = {},
+        inShouldAutoFlip[MAX_CARS] = {};
+
+    // Per-packet outputs that only apply to some cars
+    alignas(32) float
+        outAirTime[MAX_CARS] = {}, outJumpTime[MAX_CARS] = {}, outFlipTime[MAX_CARS] = {}, outAirTimeSinceJump[MAX_CARS] = {};
+    alignas(32) uint32_t
+        outDemoStarts[MAX_CARS] = {}, outFlipReset[MAX_CARS] = {},
+        outAutoFlipStarts[MAX_CARS] = {}, outFlipStarts[MAX_CARS] = {};
+
+    // Copies lanes [begin, end) of every State field
+    static void CopyLanes(State& to, const State& from, int begin, int end);
+};
+
+// Name of the first tracked Player field that isn't bit-identical between the two, or nullptr if they all are
+const char* FindTrackedStateMismatch(const RLGC::Player& a, const RLGC::Player& b);
@@ -1,4 +1,6 @@
 #include "RLBotClient.h"
+#include "RLBotGoldenTrace.h"
+#include "RLBotPlatform.h"
 #include "RLGymCPP/ActionParsers/DefaultAction.h"
 #include "RLGymCPP/ObsBuilders/AdvancedObs.h"
 #include "GigaLearnCPP/Util/InferUnit.h"
@@ -22,6 +24,23 @@ void rlbotparameters(RLBotParams& params) {
     params.deterministic = true;
     params.obsSize = 109;
     params.useGPU = true;
+    params.useLatestPacketMailbox = true;
+    params.useActionCache = true;
+    params.useStateKernel = true;
+
+    // To record the packets each bot receives (for --replay), uncomment the line below
+    // params.recordPacketsDir = "packet_logs";
+
+    // To capture every policy step (obs, action, tick, team) for training/analysis, uncomment the line below
+    // params.captureDir = "captures";
+
+    // Thread placement when packing several bots on one host
+    // Set coresPerProcess so that (bot processes per host * coresPerProcess) <= core count
+    params.threads.coresPerProcess = 0;
+    params.threads.pinTickThread = true;
+    params.threads.inferenceThreads = -1;
+    params.threads.pinInferenceThreads = true;
+    params.threads.elevatedPriority = false;
 
     params.sharedHeadConfig.layerSizes = {};
     params.sharedHeadConfig.activationType = ModelActivationType::RELU;
@@ -66,14 +85,77 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Run with --bench-state-kernel to compare the state tracking kernel against the per-car version
+    if (argc > 1 && std::string(argv[1]) == "--bench-state-kernel") {
+        RLBotBot::BenchmarkStateKernel();
+        return 0;
+    }
+
+    // Run with --replay <packet log> <golden trace> [--update-golden] [--tolerance <column>=<value>]...
+    //  to replay recorded packets and check the bot still does exactly what the golden trace recorded
+    // The golden trace is recorded on the first run, or when --update-golden is passed
+    std::filesystem::path replayPacketLogPath, replayGoldenPath;
+    bool updateGolden = false;
+    GoldenTolerances goldenTolerances;
+    if (argc > 1 && std::string(argv[1]) == "--replay") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --replay <packet log> <golden trace> [--update-golden] [--tolerance <column>=<value>]..." << std::endl;
+            return 1;
+        }
+
+        replayPacketLogPath = argv[2];
+        replayGoldenPath = argv[3];
+        for (int i = 4; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--update-golden") {
+                updateGolden = true;
+            } else if (arg == "--tolerance" && i + 1 < argc) {
+                std::string tolerance = argv[++i];
+                size_t split = tolerance.find('=');
+                std::string value = (split == std::string::npos) ? "" : tolerance.substr(split + 1);
+
+                // std::stof() throws on garbage and ignores anything after a valid prefix, so check both
+                size_t parsedLength = 0;
+                float parsedValue = 0;
+                try {
+                    parsedValue = std::stof(value, &parsedLength);
+                } catch (const std::exception&) {
+                    parsedLength = 0;
+                }
+                if (split == std::string::npos || parsedLength == 0 || parsedLength != value.size()) {
+                    std::cerr << "Error: Expected <column>=<value> after --tolerance, got: " << tolerance << std::endl;
+                    return 1;
+                }
+                goldenTolerances.perColumn[tolerance.substr(0, split)] = parsedValue;
+            } else {
+                std::cerr << "Error: Unknown argument: " << arg << std::endl;
+                return 1;
+            }
+        }
+    }
+
     RLBotParams params;
     rlbotparameters(params);
 
+    // Claim this process's cores before any other threads (or the inference runtime) exist, so they all inherit it
+    std::unique_ptr<CoreLease> coreLease;
+    if (params.threads.coresPerProcess > 0) {
+        coreLease = CoreLease::Acquire(params.threads.coresPerProcess);
+        if (coreLease)
+            params.cores = coreLease->GetCores();
+    }
+    RLBotAffinity::ApplyProcessSettings(params.threads, coreLease.get());
+
     std::filesystem::path checkpointPath;
     
     //To use a specific checkpoint uncomment the line below and set the path to POLICY.lt
     // checkpointPath = "C:/Users/FurryLover69/Downloads/GigaLearnCPP/GigaLearnCPP/build/Release/checkpoints/14594451456/POLICY.lt";
 
+    std::filesystem::path shadowCheckpointPath;
+
+    //To shadow-evaluate a candidate checkpoint alongside the bot, uncomment the line below and set the path to its POLICY.lt
+    // shadowCheckpointPath = "C:/Users/FurryLover69/Downloads/GigaLearnCPP/GigaLearnCPP/build/Release/checkpoints/15000000000/POLICY.lt";
+
     if (!checkpointPath.empty()) {
         std::cout << "Loading policy from hardcoded path: " << checkpointPath << std::endl;
     } else {
@@ -89,6 +171,9 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: No valid checkpoint path found or provided." << std::endl;
         return 1;
     }
+
+    params.checkpointHash = RLBotPlatform::HashCheckpoint(checkpointPath);
+
     // Replace with your obs and parser names
     auto obsBuilder = std::make_unique<AdvancedObs>();
     auto actionParser = std::make_unique<DefaultAction>();
@@ -102,10 +187,52 @@ int main(int argc, char* argv[]) {
         params.useGPU
     );
 
+    // The candidate gets its own obs builder and action parser, since it runs on another thread
+    std::unique_ptr<AdvancedObs> shadowObsBuilder;
+    std::unique_ptr<DefaultAction> shadowActionParser;
+    std::unique_ptr<GGL::InferUnit> shadowInferUnit;
+    if (!shadowCheckpointPath.empty()) {
+        if (std::filesystem::exists(shadowCheckpointPath)) {
+            std::cout << "Shadow-evaluating candidate policy from: " << shadowCheckpointPath << std::endl;
+            shadowObsBuilder = std::make_unique<AdvancedObs>();
+            shadowActionParser = std::make_unique<DefaultAction>();
+            shadowInferUnit = std::make_unique<GGL::InferUnit>(
+                shadowObsBuilder.get(),
+                params.obsSize,
+                shadowActionParser.get(),
+                params.sharedHeadConfig,
+                params.policyConfig,
+                shadowCheckpointPath,
+                params.useGPU
+            );
+        } else {
+            std::cerr << "Warning: Shadow checkpoint not found at: " << shadowCheckpointPath << std::endl;
+        }
+    }
+
+    // Capture also gets its own, since it builds observations on another thread
+    std::unique_ptr<AdvancedObs> captureObsBuilder;
+    std::unique_ptr<DefaultAction> captureActionParser;
+    if (!params.captureDir.empty()) {
+        captureObsBuilder = std::make_unique<AdvancedObs>();
+        captureActionParser = std::make_unique<DefaultAction>();
+    }
+    params.captureObsBuilder = captureObsBuilder.get();
+    params.captureActionParser = captureActionParser.get();
+
+    if (!replayPacketLogPath.empty()) {
+        params.obsBuilder = obsBuilder.get();
+        params.actionParser = actionParser.get();
+        params.inferUnit = inferUnit.get();
+        bool passed = GoldenTraceHarness::Run(replayPacketLogPath, replayGoldenPath, params, goldenTolerances, updateGolden);
+        return passed ? 0 : 1;
+    }
+
     std::cout << "Starting in RLBot Mode...\n";
     params.obsBuilder = obsBuilder.get();
     params.actionParser = actionParser.get();
     params.inferUnit = inferUnit.get();
+    params.shadowInferUnit = shadowInferUnit.get();
     RLBotClient::Run(params);
 
     return 0;